@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>  // std::uint64_t, std::uint32_t
+
+#include "libipc/export.h"
+#include "libipc/def.h"
+
+namespace ipc {
+namespace sync {
+
+/**
+ * class barrier
+ *
+ * A cyclic barrier in shared memory: a phase completes once 'count' participants have arrived,
+ * then the next one begins. Every opened barrier object is one participant.
+ * Giving up waiting (timeout), or a participant process dying before it arrives,
+ * breaks the barrier: the waiting ones and all the later arrive_and_wait fail from then on.
+*/
+class IPC_EXPORT barrier {
+    barrier(barrier const &) = delete;
+    barrier &operator=(barrier const &) = delete;
+
+public:
+    barrier();
+    /**
+     * 'count' is taken by the first one opening the barrier, and checked by the others
+     * (0 means taking whatever it is).
+    */
+    explicit barrier(char const *name, std::uint32_t count = 0);
+    ~barrier();
+
+    void const *native() const noexcept;
+    void *native() noexcept;
+
+    bool valid() const noexcept;
+
+    bool open(char const *name, std::uint32_t count = 0) noexcept;
+    void close() noexcept;
+
+    bool arrive_and_wait(std::uint64_t tm = ipc::invalid_value) noexcept;
+    bool broken() const noexcept;
+
+private:
+    class barrier_;
+    barrier_* p_;
+};
+
+} // namespace sync
+} // namespace ipc
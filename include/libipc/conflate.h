@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "libipc/export.h"
+#include "libipc/def.h"
+#include "libipc/buffer.h"
+#include "libipc/ipc.h"
+
+namespace ipc {
+
+/**
+ * class conflate
+ *
+ * A keyed conflating queue in shared memory, for update streams that only the latest value per key matters.
+ * Every key has its own slot: updating a key which is still pending overwrites the value in place,
+ * and receivers read only the keys updated since they read them last.
+ * At most 'keys' keys and 32 receivers, each value holds at most 'value_size' bytes.
+*/
+class IPC_EXPORT conflate {
+    conflate(conflate const &) = delete;
+    conflate &operator=(conflate const &) = delete;
+
+public:
+    conflate();
+    conflate(char const * name, std::size_t keys, std::size_t value_size, unsigned mode = ipc::sender);
+    ~conflate();
+
+    bool valid() const noexcept;
+
+    bool open(char const * name, std::size_t keys, std::size_t value_size, unsigned mode = ipc::sender);
+    void close() noexcept;
+
+    /**
+     * Sets the value of 'key', never blocks.
+     * Returns false if the data is too large, or there is no slot for a new key.
+    */
+    bool update(std::uint64_t key, void const * data, std::size_t size);
+
+    /**
+     * Receives the latest value of a key updated since it was received last,
+     * writing the key into 'key' if not null.
+     * Returns an empty buffer if timeout.
+    */
+    buff_t recv(std::uint64_t * key = nullptr, std::uint64_t tm = ipc::invalid_value);
+    buff_t try_recv(std::uint64_t * key = nullptr);
+
+private:
+    class conflate_;
+    conflate_* p_;
+};
+
+} // namespace ipc
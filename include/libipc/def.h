@@ -31,10 +31,12 @@ enum : std::uint32_t {
 };
 
 enum : std::size_t {
-    data_length     = 64,
+    data_length     = 104, // 8-byte header + payload + control words fill two cache lines
     large_msg_limit = data_length,
     large_msg_align = 1024,
     large_msg_cache = 32,
+    large_msg_magazine = 4, // chunk ids cached per sending process, per chunk size (of large_msg_cache)
+    large_msg_fanout   = 7, // channels a large message could be published on at the same time
 };
 
 enum class relat { // multiplicity of the relationship
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <string>
+#include <vector>
+#include <initializer_list>
 
 #include "libipc/export.h"
 #include "libipc/def.h"
@@ -14,9 +16,18 @@ using buff_t   = buffer;
 
 enum : unsigned {
     sender,
-    receiver
+    receiver,
+    local = 0x02, // in-process channel: kept in heap memory, buffers are handed over without copying
+    spin  = 0x04, // receiving never sleeps in the kernel: polls the ring, parked by umwait if the cpu could
+    prio_inherit = 0x08 // the locks of the channel waiters inherit priority (see: sync::mutex), if the first to connect
 };
 
+/**
+ * Tells whether a receiver wants a message by the tag it has been sent with (see: send_tagged),
+ * 'ctx' is passed through from recv_tagged.
+*/
+using tag_filter_t = bool (*)(void const * ctx, std::uint32_t tag);
+
 template <typename Flag>
 struct IPC_EXPORT chan_impl {
     static ipc::handle_t inited();
@@ -32,7 +43,15 @@ struct IPC_EXPORT chan_impl {
     static bool wait_for_recv(ipc::handle_t h, std::size_t r_count, std::uint64_t tm);
 
     static bool   send(ipc::handle_t h, void const * data, std::size_t size, std::uint64_t tm);
+    static bool   send(ipc::handle_t h, buff_t && buff, std::uint64_t tm);
+    static bool   send_tagged(ipc::handle_t h, std::uint32_t tag, void const * data, std::size_t size, std::uint64_t tm);
+    static bool   relay(ipc::handle_t h, buff_t const & buff, std::uint64_t tm);
+    static bool   send_remote(ipc::handle_t h, void const * data, std::size_t size, std::uint64_t tm);
+    static bool   send_memfd (ipc::handle_t h, int fd, std::size_t size, std::uint64_t tm);
+    static bool   send_memfd (ipc::handle_t h, void const * data, std::size_t size, std::uint64_t tm);
+    static bool   publish_all(ipc::handle_t const * hs, std::size_t n, void const * data, std::size_t size, std::uint64_t tm);
     static buff_t recv(ipc::handle_t h, std::uint64_t tm);
+    static buff_t recv_tagged(ipc::handle_t h, std::uint64_t tm, tag_filter_t accept, void const * ctx, std::uint32_t * tag);
 
     static bool   try_send(ipc::handle_t h, void const * data, std::size_t size, std::uint64_t tm);
     static buff_t try_recv(ipc::handle_t h);
@@ -108,6 +127,7 @@ public:
     */
     bool reconnect(unsigned mode) {
         if (!valid()) return false;
+        mode |= (mode_ & ipc::local); // an in-process channel stays in-process
         if (connected_ && (mode_ == mode)) return true;
         return connected_ = detail_t::reconnect(&h_, mode_ = mode);
     }
@@ -143,6 +163,52 @@ public:
         return this->send(str.c_str(), str.size() + 1, tm);
     }
 
+    /**
+     * On an in-process channel (ipc::local), the receivers get this very buffer.
+     * Otherwise the same as sending buff.data().
+    */
+    bool send(buff_t && buff, std::uint64_t tm = default_timeout) {
+        return detail_t::send(h_, std::move(buff), tm);
+    }
+
+    /**
+     * Sends a buffer received from any channel.
+     * A large message is published on this channel without copying its data,
+     * other buffers are sent as usual.
+    */
+    bool relay(buff_t const & buff, std::uint64_t tm = default_timeout) {
+        return detail_t::relay(h_, buff, tm);
+    }
+
+    /**
+     * Linux only. Instead of staging a large message in shared memory,
+     * receivers copy it straight out of this process (process_vm_readv),
+     * so they must be permitted to ptrace-attach to it.
+     * Blocks until every receiver has got the data, returns false if timeout or any copy failed.
+    */
+    bool send_remote(void const * data, std::size_t size, std::uint64_t tm = default_timeout) {
+        return detail_t::send_remote(h_, data, size, tm);
+    }
+
+    /**
+     * Linux only. Hands a sealed memfd holding 'size' bytes to the receivers,
+     * which map it read-only instead of copying. The fd must carry at least
+     * F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE, checked here and by every receiver.
+     * The fd is duplicated into every receiver by pidfd_getfd, or through /proc/<pid>/fd
+     * when yama refuses it, so unlike send_remote only the same uid is needed.
+     * Blocks until every receiver has got the fd, the caller still owns it afterwards.
+    */
+    bool send_memfd(int fd, std::size_t size, std::uint64_t tm = default_timeout) {
+        return detail_t::send_memfd(h_, fd, size, tm);
+    }
+
+    /**
+     * Copies data into a new sealed memfd, then sends it as above.
+    */
+    bool send_memfd(void const * data, std::size_t size, std::uint64_t tm = default_timeout) {
+        return detail_t::send_memfd(h_, data, size, tm);
+    }
+
     /**
      * If timeout, this function would just return false.
     */
@@ -165,6 +231,20 @@ public:
     }
 };
 
+/**
+ * Sends the same data to several channels.
+ * A large message is copied into one chunk only, which is published on every channel.
+ * Returns false if sending to any of the channels failed.
+*/
+template <typename Flag>
+bool publish_all(std::initializer_list<chan_wrapper<Flag>*> chans, void const * data, std::size_t size, 
+                 std::uint64_t tm = default_timeout) {
+    std::vector<ipc::handle_t> hs;
+    hs.reserve(chans.size());
+    for (auto c : chans) hs.push_back((c == nullptr) ? nullptr : c->handle());
+    return chan_impl<Flag>::publish_all(hs.data(), hs.size(), data, size, tm);
+}
+
 template <relat Rp, relat Rc, trans Ts>
 using chan = chan_wrapper<ipc::wr<Rp, Rc, Ts>>;
 
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>  // std::uint64_t, std::uint32_t
+
+#include "libipc/export.h"
+#include "libipc/def.h"
+
+namespace ipc {
+namespace sync {
+
+/**
+ * class latch
+ *
+ * A single-use latch in shared memory: opens for good once counted down to zero.
+ * Every opened latch object owes some count-downs (1 by default, 0 for one only waiting):
+ * if its process dies before having paid them, the latch is broken, and waiting fails.
+*/
+class IPC_EXPORT latch {
+    latch(latch const &) = delete;
+    latch &operator=(latch const &) = delete;
+
+public:
+    latch();
+    /**
+     * 'count' is taken by the first one opening the latch, and checked by the others
+     * (0 means taking whatever it is).
+     * 'owes' is how much this object is expected to count down.
+    */
+    explicit latch(char const *name, std::uint32_t count = 0, std::uint32_t owes = 1);
+    ~latch();
+
+    void const *native() const noexcept;
+    void *native() noexcept;
+
+    bool valid() const noexcept;
+
+    bool open(char const *name, std::uint32_t count = 0, std::uint32_t owes = 1) noexcept;
+    void close() noexcept;
+
+    bool count_down(std::uint32_t n = 1) noexcept;
+    bool try_wait() const noexcept;
+    bool wait(std::uint64_t tm = ipc::invalid_value) noexcept;
+    bool arrive_and_wait(std::uint32_t n = 1, std::uint64_t tm = ipc::invalid_value) noexcept;
+    bool broken() const noexcept;
+
+private:
+    class latch_;
+    latch_* p_;
+};
+
+} // namespace sync
+} // namespace ipc
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+#include <vector>
+#include <utility>
+#include <initializer_list>
+#include <algorithm>
+
+#include "libipc/def.h"
+#include "libipc/ipc.h"
+
+namespace ipc {
+
+/**
+ * class merge_wrapper
+ *
+ * Receives from several channels in one global order.
+ * Every message starts with its key (a sequence number or timestamp, as std::uint64_t),
+ * and the keys of each channel never go backwards.
+ * At most one message per channel is taken out of its ring before it could be yielded,
+ * the others stay where they are.
+ * The yielded keys never go backwards: a message coming after a timeout (see: recv)
+ * with a key smaller than the last yielded one is dropped, and counted by late().
+*/
+template <typename Flag>
+class merge_wrapper {
+public:
+    using key_t = std::uint64_t;
+
+private:
+    struct head_t {
+        key_t       key_;
+        std::size_t idx_;
+
+        // for a min-heap, ties broken by the channel order
+        friend bool operator<(head_t const & a, head_t const & b) noexcept {
+            return (a.key_ != b.key_) ? (a.key_ > b.key_) : (a.idx_ > b.idx_);
+        }
+    };
+
+    std::vector<chan_wrapper<Flag>> chans_;
+    std::vector<buff_t>             bufs_;
+    std::vector<head_t>             heap_;
+    key_t                           last_ = 0;
+    std::size_t                     late_ = 0;
+
+    bool take(std::size_t i, buff_t && buf) {
+        auto key = key_of(buf);
+        if (key < last_) {
+            ++late_;
+            return false;
+        }
+        heap_.push_back({key, i});
+        std::push_heap(heap_.begin(), heap_.end());
+        bufs_[i] = std::move(buf);
+        return true;
+    }
+
+    /// Returns the first channel which has no message waiting, or size().
+    std::size_t fill() {
+        std::size_t empty = chans_.size();
+        for (std::size_t i = 0; i < chans_.size(); ++i) {
+            while (bufs_[i].empty()) {
+                auto buf = chans_[i].try_recv();
+                if (buf.empty()) break;
+                take(i, std::move(buf));
+            }
+            if (bufs_[i].empty() && (empty == chans_.size())) empty = i;
+        }
+        return empty;
+    }
+
+public:
+    merge_wrapper() = default;
+
+    merge_wrapper(std::initializer_list<char const *> names) {
+        for (auto n : names) add(n);
+    }
+
+    /**
+     * The key of a message, 0 if it is too short to have one.
+    */
+    static key_t key_of(buff_t const & buf) noexcept {
+        key_t key {};
+        if (buf.size() >= sizeof(key)) std::memcpy(&key, buf.data(), sizeof(key));
+        return key;
+    }
+
+    /**
+     * Connects a channel as a receiver, and merges it from now on.
+    */
+    bool add(char const * name) {
+        chan_wrapper<Flag> chan {name, ipc::receiver};
+        if (!chan.valid()) return false;
+        chans_.push_back(std::move(chan));
+        bufs_ .emplace_back();
+        return true;
+    }
+
+    std::size_t size() const noexcept {
+        return chans_.size();
+    }
+
+    chan_wrapper<Flag> & channel(std::size_t i) noexcept {
+        return chans_[i];
+    }
+
+    /**
+     * The count of messages dropped for coming behind the merged order.
+    */
+    std::size_t late() const noexcept {
+        return late_;
+    }
+
+    /**
+     * Yields the message with the smallest key, once every channel has a message waiting.
+     * If some of them still have none after 'tm', yields the smallest one of the others,
+     * or an empty buffer if there is none at all.
+     * Writes the index of its channel into 'idx' if not null.
+    */
+    buff_t recv(std::uint64_t tm = invalid_value, std::size_t * idx = nullptr) {
+        auto start = std::chrono::steady_clock::now();
+        for (;;) {
+            auto i = fill();
+            if (i == chans_.size()) break;
+            std::uint64_t left = tm;
+            if (tm != invalid_value) {
+                auto spent = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                 std::chrono::steady_clock::now() - start).count());
+                left = (spent >= tm) ? 0 : (tm - spent);
+            }
+            if (left == 0) {
+                if (heap_.empty()) return {};
+                break;
+            }
+            // every channel is needed, so sleep on the waiters of any one still missing
+            auto buf = chans_[i].recv(left);
+            if (!buf.empty()) take(i, std::move(buf));
+        }
+        std::pop_heap(heap_.begin(), heap_.end());
+        auto i = heap_.back().idx_;
+        last_  = heap_.back().key_;
+        heap_.pop_back();
+        if (idx != nullptr) *idx = i;
+        return std::move(bufs_[i]);
+    }
+
+    buff_t try_recv(std::size_t * idx = nullptr) {
+        return recv(0, idx);
+    }
+};
+
+/**
+ * class merge_receiver
+ *
+ * Merges several ipc::route in order.
+*/
+
+using merge_receiver = merge_wrapper<ipc::wr<relat::single, relat::multi, trans::broadcast>>;
+
+} // namespace ipc
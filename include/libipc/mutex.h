@@ -9,13 +9,36 @@
 namespace ipc {
 namespace sync {
 
+/**
+ * The implementations behind mutex and condition.
+ * Only Linux has a choice: the a0 futex one (default), or the pthread robust one.
+ * It is picked at build time (cmake -DLIBIPC_SYNC_BACKEND=futex|pthread),
+ * then at run time by the LIBIPC_SYNC_BACKEND environment variable, or use_backend.
+ * The processes sharing the objects must use the same one: the backend of a name is recorded
+ * by the first one opening it, opening it with the other one fails (so does connecting a channel).
+*/
+enum class backend {
+    futex,
+    pthread,
+    win32
+};
+
+/// The backend the mutex and condition objects are opened with.
+IPC_EXPORT backend current_backend() noexcept;
+
+/**
+ * Switches the backend for the objects opened from now on.
+ * Returns false if it is not supported here, or some objects of the other one are still opened.
+*/
+IPC_EXPORT bool use_backend(backend b) noexcept;
+
 class IPC_EXPORT mutex {
     mutex(mutex const &) = delete;
     mutex &operator=(mutex const &) = delete;
 
 public:
     mutex();
-    explicit mutex(char const *name);
+    explicit mutex(char const *name, bool prio_inherit = false);
     ~mutex();
 
     void const *native() const noexcept;
@@ -23,7 +46,11 @@ public:
 
     bool valid() const noexcept;
 
-    bool open(char const *name) noexcept;
+    /**
+     * 'prio_inherit' asks for a priority-inheriting mutex, taken by the first one opening it.
+     * The a0 futex backend always is; the pthread one only if asked (PTHREAD_PRIO_INHERIT).
+    */
+    bool open(char const *name, bool prio_inherit = false) noexcept;
     void close() noexcept;
 
     bool lock(std::uint64_t tm = ipc::invalid_value) noexcept;
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <string>
+#include <unordered_set>
+
+#include "libipc/def.h"
+#include "libipc/ipc.h"
+#include "libipc/shm.h"
+
+namespace ipc {
+
+/**
+ * class mux_wrapper
+ *
+ * Many named logical channels over one physical channel:
+ * they share its ring, connection segment and waiters, whatever the count of them.
+ * The id of the logical channel is carried in the slot header of each message (see: send_tagged),
+ * so a receiver skips the logical channels it hasn't subscribed to without copying them.
+ * The names are checked on first use against the ones seen on the physical channel,
+ * so that two names sharing an id are refused instead of receiving each other's traffic.
+*/
+template <typename Flag>
+class mux_wrapper {
+public:
+    using id_t = std::uint32_t;
+
+    enum : std::size_t {
+        /// The count of distinct names a physical channel could carry.
+        max_names = 1024
+    };
+
+private:
+    chan_wrapper<Flag>                chan_;
+    std::unordered_set<id_t>          subs_;
+    std::unordered_set<std::uint64_t> checked_; // by key_of
+    /// The 64-bit hashes of the names seen on the physical channel, by their ids.
+    ipc::shm::handle                  names_;
+
+    static bool accept(void const * ctx, std::uint32_t id) {
+        return static_cast<mux_wrapper const *>(ctx)->subscribed(id);
+    }
+
+public:
+    /**
+     * The 64-bit FNV-1a of the name of a logical channel, never 0.
+    */
+    static std::uint64_t key_of(char const * name) noexcept {
+        std::uint64_t h = 14695981039346656037ull;
+        for (; (name != nullptr) && (*name != '\0'); ++name) {
+            h = (h ^ static_cast<unsigned char>(*name)) * 1099511628211ull;
+        }
+        return (h == 0) ? 1 : h;
+    }
+
+    /**
+     * The id of a logical channel, carried with its messages (folded key_of).
+    */
+    static id_t id_of(char const * name) noexcept {
+        auto k = key_of(name);
+        return static_cast<id_t>(k ^ (k >> 32));
+    }
+
+    /**
+     * Checks 'name' against the names seen on the physical channel, on its first use here.
+     * Fails if another name has the same id, or if there are already max_names of them.
+    */
+    bool check(char const * name) {
+        auto key = key_of(name);
+        if (checked_.find(key) != checked_.end()) return true;
+        if (!names_.valid() &&
+            ((chan_.name() == nullptr) ||
+             !names_.acquire(("__MUX__" + std::string{chan_.name()}).c_str(),
+                             sizeof(std::atomic<std::uint64_t>) * max_names))) {
+            return false;
+        }
+        auto keys = static_cast<std::atomic<std::uint64_t> *>(names_.get());
+        auto id   = static_cast<id_t>(key ^ (key >> 32));
+        for (std::size_t i = 0; i < max_names; ++i) {
+            auto &slot = keys[(id + i) % max_names];
+            auto curr  = slot.load(std::memory_order_acquire);
+            if ((curr == 0) && slot.compare_exchange_strong(curr, key, std::memory_order_acq_rel)) {
+                curr = key;
+            }
+            if (curr == key) {
+                checked_.insert(key);
+                return true;
+            }
+            if (static_cast<id_t>(curr ^ (curr >> 32)) == id) {
+                return false; // collides with another name
+            }
+        }
+        return false;
+    }
+
+    mux_wrapper() noexcept = default;
+
+    explicit mux_wrapper(char const * name, unsigned mode = ipc::sender)
+        : chan_{name, mode} {
+    }
+
+    chan_wrapper<Flag>       & channel()       noexcept { return chan_; }
+    chan_wrapper<Flag> const & channel() const noexcept { return chan_; }
+
+    bool valid() const noexcept {
+        return chan_.valid();
+    }
+
+    /**
+     * Fails if 'name' is refused by check().
+    */
+    bool subscribe(char const * name) {
+        if (!check(name)) return false;
+        subs_.insert(id_of(name));
+        return true;
+    }
+
+    void unsubscribe(char const * name) { subs_.erase(id_of(name)); }
+
+    bool subscribed(id_t id) const {
+        return subs_.find(id) != subs_.end();
+    }
+
+    /**
+     * Sends data to the logical channel 'name'. Fails if 'name' is refused by check().
+    */
+    bool send(char const * name, void const * data, std::size_t size, std::uint64_t tm = default_timeout) {
+        if (!check(name)) return false;
+        return send(id_of(name), data, size, tm);
+    }
+
+    bool send(id_t id, void const * data, std::size_t size, std::uint64_t tm = default_timeout) {
+        return chan_impl<Flag>::send_tagged(chan_.handle(), id, data, size, tm);
+    }
+
+    /**
+     * Receives the next message of any subscribed logical channel,
+     * others are skipped. Writes the logical channel into 'id' if not null.
+     * The skipped messages don't extend the timeout.
+    */
+    buff_t recv(std::uint64_t tm = invalid_value, id_t * id = nullptr) {
+        return chan_impl<Flag>::recv_tagged(chan_.handle(), tm, &mux_wrapper::accept, this, id);
+    }
+
+    buff_t try_recv(id_t * id = nullptr) {
+        return chan_impl<Flag>::recv_tagged(chan_.handle(), 0, &mux_wrapper::accept, this, id);
+    }
+};
+
+/**
+ * class mux
+ *
+ * Logical channels over one ipc::channel.
+*/
+
+using mux = mux_wrapper<ipc::wr<relat::multi, relat::multi, trans::broadcast>>;
+
+} // namespace ipc
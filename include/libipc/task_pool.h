@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "libipc/export.h"
+#include "libipc/def.h"
+
+namespace ipc {
+
+/**
+ * class task_pool
+ *
+ * Work-stealing deques in shared memory (Chase-Lev), one for each worker of the pool.
+ * A worker pushes & pops its own deque at the bottom, and steals from the top of the others
+ * when it has run out of tasks. An idle worker parks on a waiter until new tasks come.
+ * A task is a 64-bit value, such as an id of a record in shared memory.
+*/
+class IPC_EXPORT task_pool {
+    task_pool(task_pool const &) = delete;
+    task_pool &operator=(task_pool const &) = delete;
+
+public:
+    using task_t = std::uint64_t;
+
+    enum : std::size_t {
+        max_workers      = 32,
+        default_capacity = 1024
+    };
+
+    task_pool();
+    explicit task_pool(char const * name, std::size_t capacity = default_capacity);
+    ~task_pool();
+
+    bool valid() const noexcept;
+
+    /**
+     * Joins the pool as a worker, taking a deque of it.
+     * A deque left by a closed worker, or by a dead one, could be taken again with its tasks.
+    */
+    bool open(char const * name, std::size_t capacity = default_capacity);
+    void close() noexcept;
+
+    /**
+     * The index of the deque of this worker.
+    */
+    std::size_t index() const noexcept;
+
+    /**
+     * Pushes a task into the own deque, returns false if it is full.
+    */
+    bool push(task_t task);
+
+    /**
+     * Pops the latest task of the own deque.
+    */
+    bool pop(task_t & task);
+
+    /**
+     * Steals the oldest task of any other deque.
+    */
+    bool steal(task_t & task);
+
+    /**
+     * Pops, or steals, or parks until a task is available.
+     * Returns false if timeout, or quit_waiting has been called.
+    */
+    bool take(task_t & task, std::uint64_t tm = ipc::invalid_value);
+
+    /**
+     * Wakes up this worker if it is parked in take, and makes take give up from now on.
+    */
+    void quit_waiting();
+
+private:
+    class task_pool_;
+    task_pool_* p_;
+};
+
+} // namespace ipc
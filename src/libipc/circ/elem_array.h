@@ -10,6 +10,7 @@
 
 #include "libipc/circ/elem_def.h"
 #include "libipc/platform/detail.h"
+#include "libipc/utility/utility.h"
 
 namespace ipc {
 namespace circ {
@@ -133,7 +134,35 @@ public:
     template <typename Q, typename F, typename R>
     bool pop(Q* que, cursor_t* cur, F&& f, R&& out) {
         if (cur == nullptr) return false;
-        return head_.pop(que, *cur, std::forward<F>(f), std::forward<R>(out), block_);
+        if (!head_.pop(que, *cur, std::forward<F>(f), std::forward<R>(out), block_)) {
+            return false;
+        }
+        // warm up the next slots, while the caller is busy with this one
+        prefetch_next(read_index(*cur, std::integral_constant<bool, relat_trait<Policy>::is_broadcast>{}));
+        return true;
+    }
+
+    /**
+     * The word written when the next message for 'cur' is committed.
+     * It may move as the ring goes round, so ask again before every wait.
+    */
+    void const * commit_addr(cursor_t cur) const noexcept {
+        return head_.commit_addr(cur, block_);
+    }
+
+private:
+    /// A broadcast receiver has its own read index, the unicast ones share the one of the policy.
+    cursor_t read_index(cursor_t cur, std::true_type) const noexcept {
+        return cur;
+    }
+
+    cursor_t read_index(cursor_t, std::false_type) const noexcept {
+        return head_.rd_.load(std::memory_order_relaxed);
+    }
+
+    void prefetch_next(cursor_t cur) const noexcept {
+        ipc::prefetch(block_ + index_of(cur)    , elem_size);
+        ipc::prefetch(block_ + index_of(cur + 1), elem_size);
     }
 };
 
@@ -0,0 +1,368 @@
+
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+#include "libipc/conflate.h"
+#include "libipc/shm.h"
+#include "libipc/rw_lock.h"
+#include "libipc/waiter.h"
+#include "libipc/pool_alloc.h"
+
+#include "libipc/utility/pimpl.h"
+#include "libipc/utility/log.h"
+#include "libipc/memory/resource.h"
+#include "libipc/platform/detail.h"
+#if defined(IPC_OS_WINDOWS_)
+#include "libipc/platform/win/wait_word.h"
+#elif defined(IPC_OS_LINUX_)
+#include "libipc/platform/linux/wait_word.h"
+#elif defined(IPC_OS_QNX_)
+#include "libipc/platform/posix/wait_word.h"
+#endif
+
+namespace {
+
+using ipc::detail::sync::this_process;
+using ipc::detail::sync::process_alive;
+
+constexpr unsigned max_readers = 32;
+
+struct head_t {
+    std::atomic<std::uint32_t> readers_; // a bit for each receiver
+    std::atomic<std::uint32_t> dirty_;   // updated times, for waiting
+    std::atomic<std::uint32_t> pids_[max_readers]; // the process of each bit, 0 while it is being taken
+};
+
+/**
+ * slot_t::state_ is empty, ready, or the pid of the sender claiming it for a new key (see: claim_of):
+ * a claim left by a dead sender is given up, since nobody has got the slot yet.
+*/
+enum : std::uint32_t {
+    slot_empty,
+    slot_ready
+};
+
+constexpr std::uint32_t claim_of(std::uint32_t pid) noexcept {
+    return pid << 1; // even, never 0 or slot_ready
+}
+
+/**
+ * slot_t::seq_: the seqlock in the low 32 bits, odd while a sender is writing,
+ * and then the pid of that sender in the high 32 bits, so the next one could take over if it has died.
+*/
+constexpr std::uint64_t make_seq(std::uint32_t seq, std::uint32_t pid) noexcept {
+    return (static_cast<std::uint64_t>(pid) << 32) | seq;
+}
+
+constexpr std::uint32_t seq_of  (std::uint64_t w) noexcept { return static_cast<std::uint32_t>(w); }
+constexpr std::uint32_t owner_of(std::uint64_t w) noexcept { return static_cast<std::uint32_t>(w >> 32); }
+
+struct alignas(std::uint64_t) slot_t {
+    std::atomic<std::uint32_t> state_;
+    std::atomic<std::uint32_t> pending_; // receivers which haven't read the value yet
+    std::atomic<std::uint64_t> seq_;
+    std::atomic<std::uint32_t> size_;
+    std::uint64_t              key_;
+    // the value follows
+};
+
+constexpr std::size_t aligned(std::size_t size, std::size_t alignment) noexcept {
+    return ((size - 1) & ~(alignment - 1)) + alignment;
+}
+
+std::size_t capacity_of(std::size_t keys) noexcept {
+    // keep the table at most half full
+    std::size_t cap = 2;
+    while (cap < keys * 2) cap <<= 1;
+    return cap;
+}
+
+} // internal-linkage
+
+namespace ipc {
+
+class conflate::conflate_ : public ipc::pimpl<conflate_> {
+public:
+    ipc::shm::handle    shm_;
+    ipc::detail::waiter waiter_;
+    std::size_t         cap_    = 0;
+    std::size_t         vsize_  = 0;
+    std::size_t         stride_ = 0;
+    std::size_t         cursor_ = 0;
+    std::uint32_t       bit_    = 0; // 0 if not a receiver
+    std::vector<std::uint32_t> seen_; // the seq of the value last read from each slot
+
+    head_t * head() const noexcept {
+        return static_cast<head_t *>(shm_.get());
+    }
+
+    slot_t * slot(std::size_t i) const noexcept {
+        return reinterpret_cast<slot_t *>(
+            static_cast<byte_t *>(shm_.get()) + aligned(sizeof(head_t), alignof(slot_t)) + stride_ * i);
+    }
+
+    static byte_t * value_of(slot_t * s) noexcept {
+        return reinterpret_cast<byte_t *>(s) + sizeof(slot_t);
+    }
+
+    slot_t * find(std::uint64_t key) const noexcept {
+        std::size_t mask = cap_ - 1;
+        std::size_t i = static_cast<std::size_t>((key * 0x9e3779b97f4a7c15ull) >> 32) & mask;
+        for (std::size_t n = 0; n < cap_; ++n, i = (i + 1) & mask) {
+            slot_t * s = slot(i);
+            auto st = s->state_.load(std::memory_order_acquire);
+            for (unsigned k = 0; st != slot_ready;) {
+                if (st == slot_empty) {
+                    if (s->state_.compare_exchange_strong(st, claim_of(this_process()), std::memory_order_acq_rel)) {
+                        s->key_ = key;
+                        s->state_.store(slot_ready, std::memory_order_release);
+                        return s;
+                    }
+                    continue; // st has been reloaded
+                }
+                // claimed by another sender, wait for its key
+                if ((k >= 32) && !process_alive(st >> 1)) {
+                    s->state_.compare_exchange_strong(st, slot_empty, std::memory_order_acq_rel);
+                    continue;
+                }
+                ipc::yield(k);
+                st = s->state_.load(std::memory_order_acquire);
+            }
+            if (s->key_ == key) return s;
+        }
+        return nullptr;
+    }
+
+    static unsigned index_of(std::uint32_t bit) noexcept {
+        unsigned i = 0;
+        while ((bit >>= 1) != 0) ++i;
+        return i;
+    }
+
+    /// Frees the bits of the receivers which have died without disconnecting.
+    void reclaim() noexcept {
+        auto readers = head()->readers_.load(std::memory_order_acquire);
+        for (unsigned i = 0; i < max_readers; ++i) {
+            if ((readers & (std::uint32_t(1) << i)) == 0) continue;
+            auto pid = head()->pids_[i].load(std::memory_order_acquire);
+            if ((pid == 0) || process_alive(pid)) continue;
+            // only one of the reclaimers clears the bit
+            if (head()->pids_[i].compare_exchange_strong(pid, 0, std::memory_order_acq_rel)) {
+                head()->readers_.fetch_and(~(std::uint32_t(1) << i), std::memory_order_acq_rel);
+            }
+        }
+    }
+
+    bool connect() noexcept {
+        reclaim();
+        auto readers = head()->readers_.load(std::memory_order_relaxed);
+        for (;;) {
+            if (readers == ~std::uint32_t(0)) {
+                ipc::error("fail: conflate, too many receivers.\n");
+                return false;
+            }
+            auto bit = ~readers & (readers + 1);
+            if (head()->readers_.compare_exchange_weak(readers, readers | bit, std::memory_order_acq_rel)) {
+                bit_ = bit;
+                head()->pids_[index_of(bit)].store(this_process(), std::memory_order_release);
+                break;
+            }
+        }
+        seen_.assign(cap_, ~std::uint32_t(0)); // odd, never a seq of a value
+        // a new receiver starts with all the latest values
+        for (std::size_t i = 0; i < cap_; ++i) {
+            if (slot(i)->state_.load(std::memory_order_acquire) == slot_ready) {
+                slot(i)->pending_.fetch_or(bit_, std::memory_order_release);
+            }
+        }
+        return true;
+    }
+
+    void disconnect() noexcept {
+        if (bit_ == 0) return;
+        head()->pids_[index_of(bit_)].store(0, std::memory_order_release);
+        head()->readers_.fetch_and(~bit_, std::memory_order_acq_rel);
+        bit_ = 0;
+        waiter_.quit_waiting();
+    }
+
+    /**
+     * Reads the value of a slot by the seqlock.
+     * Gives up if the sender writing it has died, the next update would take it over.
+    */
+    buff_t read(slot_t * s, std::uint32_t & ver) {
+        void *      buf  = nullptr;
+        std::size_t size = 0;
+        for (unsigned k = 0;;) {
+            auto seq = s->seq_.load(std::memory_order_acquire);
+            if (seq_of(seq) & 1) {
+                if ((k >= 32) && !process_alive(owner_of(seq))) {
+                    if (buf != nullptr) ipc::mem::free(buf, size);
+                    return {};
+                }
+                ipc::yield(k);
+                continue;
+            }
+            auto curr = static_cast<std::size_t>(s->size_.load(std::memory_order_relaxed));
+            if (curr != size) {
+                if (buf != nullptr) ipc::mem::free(buf, size);
+                buf  = (curr == 0) ? nullptr : ipc::mem::alloc(curr);
+                size = curr;
+            }
+            if (size != 0) std::memcpy(buf, value_of(s), size);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (s->seq_.load(std::memory_order_relaxed) == seq) {
+                ver = seq_of(seq);
+                break;
+            }
+        }
+        // a new key might have no value yet
+        if (buf == nullptr) return {};
+        return buff_t{buf, size, ipc::mem::free};
+    }
+
+    buff_t scan(std::uint64_t * key) {
+        for (std::size_t n = 0; n < cap_; ++n) {
+            std::size_t i = cursor_;
+            slot_t * s = slot(i);
+            cursor_ = (cursor_ + 1) & (cap_ - 1);
+            if ((s->state_.load(std::memory_order_acquire) != slot_ready) ||
+                (s->pending_.load(std::memory_order_acquire) & bit_) == 0) {
+                continue;
+            }
+            // clear first, so an update while reading would be received again
+            s->pending_.fetch_and(~bit_, std::memory_order_acq_rel);
+            std::uint32_t ver = 0;
+            auto buff = read(s, ver);
+            // the pending bit of a value might be set after it has been read already
+            if (buff.empty() || (ver == seen_[i])) continue;
+            seen_[i] = ver;
+            if (key != nullptr) *key = s->key_;
+            return buff;
+        }
+        return {};
+    }
+};
+
+conflate::conflate()
+    : p_(p_->make()) {
+}
+
+conflate::conflate(char const * name, std::size_t keys, std::size_t value_size, unsigned mode)
+    : conflate() {
+    open(name, keys, value_size, mode);
+}
+
+conflate::~conflate() {
+    close();
+    p_->clear();
+}
+
+bool conflate::valid() const noexcept {
+    return impl(p_)->shm_.valid() && impl(p_)->waiter_.valid();
+}
+
+bool conflate::open(char const * name, std::size_t keys, std::size_t value_size, unsigned mode) {
+    close();
+    if ((name == nullptr) || (name[0] == '\0') || (keys == 0) || (value_size == 0)) {
+        ipc::error("fail: conflate::open(%s, %zd, %zd)\n", name, keys, value_size);
+        return false;
+    }
+    ipc::detail::waiter::init();
+    auto p = impl(p_);
+    p->cap_    = capacity_of(keys);
+    p->vsize_  = value_size;
+    p->stride_ = aligned(sizeof(slot_t) + value_size, alignof(std::max_align_t));
+    ipc::string prefix = "__CF_CONN__" + ipc::to_string(keys) + "__" + ipc::to_string(value_size) + "__";
+    if (!p->shm_.acquire((prefix + name).c_str(),
+                         aligned(sizeof(head_t), alignof(slot_t)) + p->stride_ * p->cap_)) {
+        return false;
+    }
+    if (!p->waiter_.open((prefix + name).c_str())) {
+        p->shm_.release();
+        return false;
+    }
+    if ((mode & ipc::receiver) && !p->connect()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void conflate::close() noexcept {
+    auto p = impl(p_);
+    if (!p->shm_.valid()) return;
+    p->disconnect();
+    p->waiter_.close();
+    p->shm_.release();
+    p->cursor_ = 0;
+}
+
+bool conflate::update(std::uint64_t key, void const * data, std::size_t size) {
+    auto p = impl(p_);
+    if (!valid()) {
+        ipc::error("fail: conflate::update, not opened.\n");
+        return false;
+    }
+    if ((data == nullptr) || (size == 0) || (size > p->vsize_)) {
+        ipc::error("fail: conflate::update(%p, %zd), the value size is %zd\n", data, size, p->vsize_);
+        return false;
+    }
+    slot_t * s = p->find(key);
+    if (s == nullptr) {
+        ipc::error("fail: conflate::update, no slot for a new key.\n");
+        return false;
+    }
+    // lock against other senders, taking over from one which has died while writing
+    auto me = this_process();
+    std::uint32_t seq;
+    for (unsigned k = 0;; ipc::yield(k)) {
+        auto w = s->seq_.load(std::memory_order_relaxed);
+        seq = seq_of(w);
+        if ((seq & 1) == 0) {
+            if (s->seq_.compare_exchange_weak(w, make_seq(++seq, me), std::memory_order_acquire)) break;
+        }
+        else if ((k >= 32) && !process_alive(owner_of(w)) &&
+                 s->seq_.compare_exchange_strong(w, make_seq(seq, me), std::memory_order_acquire)) {
+            break;
+        }
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    s->size_.store(static_cast<std::uint32_t>(size), std::memory_order_relaxed);
+    std::memcpy(conflate_::value_of(s), data, size);
+    s->seq_.store(make_seq(seq + 1, 0), std::memory_order_release);
+    // mark it for all receivers, then wake them up
+    auto readers = p->head()->readers_.load(std::memory_order_acquire);
+    if (readers != 0) {
+        s->pending_.fetch_or(readers, std::memory_order_acq_rel);
+        p->head()->dirty_.fetch_add(1, std::memory_order_release);
+        p->waiter_.broadcast();
+    }
+    return true;
+}
+
+buff_t conflate::recv(std::uint64_t * key, std::uint64_t tm) {
+    auto p = impl(p_);
+    if (!valid() || (p->bit_ == 0)) {
+        ipc::error("fail: conflate::recv, not a receiver.\n");
+        return {};
+    }
+    for (;;) {
+        auto dirty = p->head()->dirty_.load(std::memory_order_acquire);
+        auto buff  = p->scan(key);
+        if (!buff.empty() || (tm == 0)) return buff;
+        if (!p->waiter_.wait_if([p, dirty] {
+                return p->head()->dirty_.load(std::memory_order_acquire) == dirty;
+            }, tm)) {
+            return {};
+        }
+        if (p->bit_ == 0) return {};
+    }
+}
+
+buff_t conflate::try_recv(std::uint64_t * key) {
+    return recv(key, 0);
+}
+
+} // namespace ipc
@@ -8,6 +8,11 @@
 #include <string>
 #include <vector>
 #include <array>
+#include <bitset>
+#include <chrono>
+#include <thread>
+#include <climits>        // CHAR_BIT
+#include <limits>
 #include <cassert>
 
 #include "libipc/ipc.h"
@@ -18,6 +23,7 @@
 #include "libipc/policy.h"
 #include "libipc/rw_lock.h"
 #include "libipc/waiter.h"
+#include "libipc/local_chan.h"
 
 #include "libipc/utility/log.h"
 #include "libipc/utility/id_pool.h"
@@ -26,8 +32,20 @@
 
 #include "libipc/memory/resource.h"
 #include "libipc/platform/detail.h"
+#include "libipc/platform/monitor_wait.h"
+#if defined(IPC_OS_WINDOWS_)
+#include "libipc/platform/win/wait_word.h"
+#elif defined(IPC_OS_LINUX_)
+#include "libipc/platform/linux/wait_word.h"
+#elif defined(IPC_OS_QNX_)
+#include "libipc/platform/posix/wait_word.h"
+#endif
 #include "libipc/circ/elem_array.h"
 
+#if defined(IPC_OS_LINUX_)
+#include "libipc/platform/linux/remote_mem.h"
+#endif
+
 namespace {
 
 using msg_id_t = std::uint32_t;
@@ -36,36 +54,122 @@ using acc_t    = std::atomic<msg_id_t>;
 template <std::size_t DataSize, std::size_t AlignSize>
 struct msg_t;
 
+/**
+ * The packed header of a slot, 8 bytes.
+ * id_ is kept in full, the fragments of a message are reassembled by it (see: recv_cache_t).
+ * cc_id_ is unique among the connections alive on the channel (see: conn_acc_t),
+ * so a connection never takes another one's messages for its own.
+ * size_ is the count of data bytes in the slot. The rest is told by a prefix of the payload,
+ * only for the messages which need it (see: msg_t::prefix_size):
+ *  - tagged_:  the tag, which lets a receiver skip a message before copying it (see: recv_tagged),
+ *  - more_:    the bytes left from this fragment on, if it isn't the last one,
+ *  - storage_: the size of the message, whose data is in a chunk (see: storage_desc_t).
+*/
 template <std::size_t AlignSize>
 struct msg_t<0, AlignSize> {
-    msg_id_t     cc_id_;
-    msg_id_t     id_;
-    std::int32_t remain_;
-    bool         storage_;
+    msg_id_t      id_;
+    std::uint16_t cc_id_;
+    std::uint16_t size_    : 13;
+    std::uint16_t more_    : 1;
+    std::uint16_t storage_ : 1;
+    std::uint16_t tagged_  : 1;
+};
+
+static_assert(sizeof(msg_t<0, alignof(std::uint64_t)>) == 8, "The slot header should be 8 bytes.");
+static_assert(ipc::data_length < (1u << 13), "The size of a fragment should fit in msg_t::size_.");
+
+constexpr std::size_t max_msg_size = (std::size_t(1) << 30) - 1;
+
+/// The data of a large message: which chunk, and which publication of the chunk.
+struct storage_desc_t {
+    ipc::storage_id_t id_;
+    std::uint32_t     slot_;
 };
 
+/**
+ * Set in storage_desc_t::slot_ if the chunk holds a remote_rec_t instead of the data:
+ * receivers copy the data straight out of the sender (see: send_remote).
+*/
+constexpr std::uint32_t remote_slot_flag = 0x80000000u;
+
+struct remote_rec_t {
+    std::int32_t                 pid_;
+    std::int32_t                 fd_;      // a sealed memfd of the sender, or -1 (read from addr_)
+    std::uint64_t                addr_;
+    std::uint64_t                size_;
+    std::atomic<ipc::circ::cc_t> pending_; // receivers which haven't finished copying (see: owe_rc)
+    std::atomic<std::uint32_t>   state_;   // see: remote_state
+};
+
+enum remote_state : std::uint32_t {
+    remote_cancelled = 0x1,
+    remote_failed    = 0x2
+};
+
+/**
+ * A slot: 'rest' is the bytes of the message from this fragment on,
+ * or the size of the message if its data is in a chunk, in which case 'data' is a storage_desc_t
+ * and 'size' is 0. A 'tag' of 0 isn't carried.
+*/
 template <std::size_t DataSize, std::size_t AlignSize>
 struct msg_t : msg_t<0, AlignSize> {
     std::aligned_storage_t<DataSize, AlignSize> data_ {};
 
+    /// The bytes of the payload taken by the prefix.
+    static constexpr std::size_t prefix_size(bool tagged, bool sized) noexcept {
+        return (tagged ? sizeof(std::uint32_t) : 0) + (sized ? sizeof(std::uint32_t) : 0);
+    }
+
     msg_t() = default;
-    msg_t(msg_id_t cc_id, msg_id_t id, std::int32_t remain, void const * data, std::size_t size)
-        : msg_t<0, AlignSize> {cc_id, id, remain, (data == nullptr) || (size == 0)} {
+    msg_t(std::uint16_t cc_id, msg_id_t id, std::uint32_t tag, std::uint32_t rest, void const * data, std::size_t size)
+        : msg_t<0, AlignSize> {id, cc_id, static_cast<std::uint16_t>(size),
+                               (size != 0) && (rest > size), (data == nullptr) || (size == 0), tag != 0} {
+        auto p = reinterpret_cast<ipc::byte_t *>(&data_);
+        if (this->tagged_) {
+            std::memcpy(p, &tag, sizeof(tag));
+            p += sizeof(tag);
+        }
+        if (this->more_ || this->storage_) {
+            std::memcpy(p, &rest, sizeof(rest));
+            p += sizeof(rest);
+        }
         if (this->storage_) {
             if (data != nullptr) {
-                // copy storage-id
-                *reinterpret_cast<ipc::storage_id_t*>(&data_) =
-                     *static_cast<ipc::storage_id_t const *>(data);
+                // copy storage descriptor
+                std::memcpy(p, data, sizeof(storage_desc_t));
             }
         }
-        else std::memcpy(&data_, data, size);
+        else std::memcpy(p, data, size);
+    }
+
+    std::uint32_t tag() const noexcept {
+        std::uint32_t tag = 0;
+        if (this->tagged_) std::memcpy(&tag, &data_, sizeof(tag));
+        return tag;
+    }
+
+    /// See: the constructor.
+    std::uint32_t rest() const noexcept {
+        if (!this->more_ && !this->storage_) return this->size_;
+        std::uint32_t rest;
+        std::memcpy(&rest, reinterpret_cast<ipc::byte_t const *>(&data_) + prefix_size(this->tagged_, false), sizeof(rest));
+        return rest;
+    }
+
+    void const * data() const noexcept {
+        return reinterpret_cast<ipc::byte_t const *>(&data_) + prefix_size(this->tagged_, this->more_ || this->storage_);
+    }
+
+    storage_desc_t storage_desc() const noexcept {
+        storage_desc_t desc;
+        std::memcpy(&desc, data(), sizeof(desc));
+        return desc;
     }
 };
 
-template <typename T>
-ipc::buff_t make_cache(T& data, std::size_t size) {
+inline ipc::buff_t make_cache(void const * data, std::size_t fill, std::size_t size) {
     auto ptr = ipc::mem::alloc(size);
-    std::memcpy(ptr, &data, (ipc::detail::min)(sizeof(data), size));
+    std::memcpy(ptr, data, (ipc::detail::min)(fill, size));
     return { ptr, size, ipc::mem::free };
 }
 
@@ -85,37 +189,185 @@ struct cache_t {
     }
 };
 
-auto cc_acc() {
-    static ipc::shm::handle acc_h("__CA_CONN__", sizeof(acc_t));
-    return static_cast<acc_t*>(acc_h.get());
-}
+/// The messages of a receiver which are still being reassembled from fragments.
+struct recv_cache_t {
+    enum : unsigned {
+        epoch_bits = 16
+    };
+
+    ipc::unordered_map<msg_id_t, cache_t> parts_;
+    msg_id_t                              epoch_ = 0;
+
+    /**
+     * Once the ids enter a new epoch, drops the messages started two epochs before:
+     * their senders have given up on them (timeout), the rest would never come.
+    */
+    void expire(msg_id_t id) {
+        msg_id_t epoch = id >> epoch_bits;
+        if (epoch == epoch_) return;
+        epoch_ = epoch;
+        for (auto it = parts_.begin(); it != parts_.end();) {
+            // the ids wrap around, and a message started a bit later than 'id' is kept
+            if (static_cast<std::int32_t>(id - it->first) >= (std::int32_t(2) << epoch_bits)) {
+                it = parts_.erase(it);
+            }
+            else ++it;
+        }
+    }
+
+    void clear() noexcept {
+        parts_.clear();
+    }
+};
+
+/**
+ * The counter of the message ids of a channel, and the processes of its connections:
+ * the id of a connection is the index of its entry + 1, so it is unique among the ones alive.
+ * The entry of a dead process is taken over.
+*/
+struct conn_acc_t {
+    enum : std::size_t {
+        max_conns = 1024
+    };
+
+    acc_t                      msg_acc_;
+    std::atomic<std::uint32_t> pids_[max_conns];
+
+    /// Returns 0 if all the entries are in use.
+    std::uint16_t claim() noexcept {
+        auto pid = ipc::detail::sync::this_process();
+        for (std::size_t i = 0; i < max_conns; ++i) {
+            std::uint32_t none = 0;
+            if (pids_[i].compare_exchange_strong(none, pid, std::memory_order_acq_rel)) {
+                return static_cast<std::uint16_t>(i + 1);
+            }
+        }
+        for (std::size_t i = 0; i < max_conns; ++i) {
+            auto dead = pids_[i].load(std::memory_order_acquire);
+            if ((dead == 0) || ipc::detail::sync::process_alive(dead)) continue;
+            if (pids_[i].compare_exchange_strong(dead, pid, std::memory_order_acq_rel)) {
+                return static_cast<std::uint16_t>(i + 1);
+            }
+        }
+        return 0;
+    }
+
+    void unclaim(std::uint16_t cc_id) noexcept {
+        if ((cc_id == 0) || (cc_id > max_conns)) return;
+        pids_[cc_id - 1].store(0, std::memory_order_release);
+    }
+};
+
+static_assert(conn_acc_t::max_conns < (std::numeric_limits<std::uint16_t>::max)(), "A connection id should fit in msg_t::cc_id_.");
 
 IPC_CONSTEXPR_ std::size_t align_chunk_size(std::size_t size) noexcept {
     return (((size - 1) / ipc::large_msg_align) + 1) * ipc::large_msg_align;
 }
 
+/**
+ * A chunk could be published on several channels at the same time (see: relay).
+ * Each publication takes a slot holding the receivers which haven't consumed it yet,
+ * and the chunk is recycled when its last publication is done.
+ * A slot is owned through slots_, not through its receivers: only the one which takes
+ * the receivers of the slot down to none gives it back, so a new publication never
+ * gets a slot the previous one is still finishing with.
+*/
+struct chunk_head_t {
+    std::atomic<std::uint32_t>   pubs_;
+    std::atomic<std::uint32_t>   slots_; // the slots in use
+    std::atomic<ipc::circ::cc_t> conns_[ipc::large_msg_fanout];
+};
+
+static_assert(ipc::large_msg_fanout <= 32, "The slots in use should fit in chunk_head_t::slots_.");
+
+IPC_CONSTEXPR_ std::size_t chunk_head_size() noexcept {
+    return ipc::make_align(alignof(std::max_align_t), sizeof(chunk_head_t));
+}
+
 IPC_CONSTEXPR_ std::size_t calc_chunk_size(std::size_t size) noexcept {
-    return ipc::make_align(alignof(std::max_align_t), align_chunk_size(
-           ipc::make_align(alignof(std::max_align_t), sizeof(std::atomic<ipc::circ::cc_t>)) + size));
+    return ipc::make_align(alignof(std::max_align_t), align_chunk_size(chunk_head_size() + size));
 }
 
 struct chunk_t {
-    std::atomic<ipc::circ::cc_t> &conns() noexcept {
-        return *reinterpret_cast<std::atomic<ipc::circ::cc_t> *>(this);
+    chunk_head_t &head() noexcept {
+        return *reinterpret_cast<chunk_head_t *>(this);
+    }
+
+    std::atomic<ipc::circ::cc_t> &conns(std::uint32_t slot) noexcept {
+        return head().conns_[slot];
     }
 
     void *data() noexcept {
-        return reinterpret_cast<ipc::byte_t *>(this)
-             + ipc::make_align(alignof(std::max_align_t), sizeof(std::atomic<ipc::circ::cc_t>));
+        return reinterpret_cast<ipc::byte_t *>(this) + chunk_head_size();
+    }
+
+    /// Returns the slot of the new publication, or -1 if all slots are in use.
+    std::int32_t publish(ipc::circ::cc_t conns) noexcept {
+        if (conns == 0) return -1; // nobody could ever end it
+        head().pubs_.fetch_add(1, std::memory_order_relaxed);
+        auto slots = head().slots_.load(std::memory_order_acquire);
+        for (;;) {
+            std::uint32_t k = 0;
+            while ((k < ipc::large_msg_fanout) && (slots & (1u << k))) ++k;
+            if (k >= ipc::large_msg_fanout) break;
+            if (head().slots_.compare_exchange_weak(slots, slots | (1u << k), std::memory_order_acq_rel)) {
+                this->conns(k).store(conns, std::memory_order_release);
+                return static_cast<std::int32_t>(k);
+            }
+        }
+        // the caller must hold a publication, so pubs_ wouldn't drop to 0 here
+        head().pubs_.fetch_sub(1, std::memory_order_relaxed);
+        return -1;
+    }
+
+    /**
+     * Ends the publication in 'slot', unless its receivers have already been taken down to none.
+     * Returns true if this was the last publication of the chunk.
+    */
+    bool unpublish(std::uint32_t slot) noexcept {
+        if (conns(slot).exchange(0, std::memory_order_acq_rel) == 0) {
+            return false; // ended by someone else
+        }
+        return release_slot(slot);
+    }
+
+    /**
+     * For the one which has taken the receivers of 'slot' down to none (see: sub_rc).
+     * Returns true if this was the last publication of the chunk.
+    */
+    bool release_slot(std::uint32_t slot) noexcept {
+        head().slots_.fetch_and(~(1u << slot), std::memory_order_release);
+        return unhold();
+    }
+
+    /// Drops a reference which isn't bound to any slot (see: publish_all).
+    bool unhold() noexcept {
+        return head().pubs_.fetch_sub(1, std::memory_order_acq_rel) == 1;
     }
 };
 
+using chunk_slab_t = ipc::id_slab<0, 0, ipc::large_msg_cache>;
+
 struct chunk_info_t {
-    ipc::id_pool<> pool_;
-    ipc::spin_lock lock_;
+    /// The ids of the chunks; the ones cached by a magazine are marked with its process.
+    chunk_slab_t pool_;
+    /// Set when an acquire found the pool empty: the magazines are flushed back.
+    std::atomic<bool> starving_;
+
+    /// Gives the ids cached by dead processes back to the pool.
+    bool reclaim_dead() noexcept {
+        return pool_.reclaim([](std::uint32_t pid) {
+            return !ipc::detail::sync::process_alive(pid);
+        }) > 0;
+    }
+
+    /// Takes back the ids cached by any process, for an acquire which found the pool empty.
+    bool reclaim_all() noexcept {
+        return pool_.reclaim([](std::uint32_t) { return true; }) > 0;
+    }
 
     IPC_CONSTEXPR_ static std::size_t chunks_mem_size(std::size_t chunk_size) noexcept {
-        return ipc::id_pool<>::max_count * chunk_size;
+        return chunk_slab_t::max_count * chunk_size;
     }
 
     ipc::byte_t *chunks_mem() noexcept {
@@ -128,61 +380,115 @@ struct chunk_info_t {
     }
 };
 
-auto& chunk_storages() {
-    class chunk_handle_t {
-        ipc::shm::handle handle_;
-
-    public:
-        chunk_info_t *get_info(std::size_t chunk_size) {
-            if (!handle_.valid() &&
-                !handle_.acquire( ("__CHUNK_INFO__" + ipc::to_string(chunk_size)).c_str(), 
-                                  sizeof(chunk_info_t) + chunk_info_t::chunks_mem_size(chunk_size) )) {
-                ipc::error("[chunk_storages] chunk_shm.id_info_.acquire failed: chunk_size = %zd\n", chunk_size);
-                return nullptr;
-            }
-            auto info = static_cast<chunk_info_t*>(handle_.get());
-            if (info == nullptr) {
-                ipc::error("[chunk_storages] chunk_shm.id_info_.get failed: chunk_size = %zd\n", chunk_size);
-                return nullptr;
-            }
-            return info;
+class chunk_handle_t {
+    ipc::shm::handle handle_;
+
+    /**
+     * A per-process magazine of chunk ids, in front of the lock-free pool.
+     * It is refilled a batch of large_msg_magazine ids at a time, and the recycled ids
+     * are collected in it and given back a batch at a time, each batch with a single CAS.
+     * The ids in it are marked with this process: the ones of a dead process are reclaimed,
+     * and an acquire which finds the pool empty takes back the ones of idle processes too.
+    */
+    ipc::spin_lock mag_lock_;
+    ipc::slab_magazine<chunk_slab_t, ipc::large_msg_magazine * 2> mag_ {nullptr, &ipc::detail::sync::this_process};
+
+    static_assert(ipc::large_msg_magazine <= chunk_slab_t::max_count / 8,
+                  "A magazine should hold only a small share of the chunk ids.");
+
+public:
+    chunk_info_t *get_info(std::size_t chunk_size) {
+        if (!handle_.valid() &&
+            !handle_.acquire( ("__CHUNK_INFO__" + ipc::to_string(chunk_size)).c_str(), 
+                              sizeof(chunk_info_t) + chunk_info_t::chunks_mem_size(chunk_size) )) {
+            ipc::error("[chunk_storages] chunk_shm.id_info_.acquire failed: chunk_size = %zd\n", chunk_size);
+            return nullptr;
         }
-    };
+        auto info = static_cast<chunk_info_t*>(handle_.get());
+        if (info == nullptr) {
+            ipc::error("[chunk_storages] chunk_shm.id_info_.get failed: chunk_size = %zd\n", chunk_size);
+            return nullptr;
+        }
+        return info;
+    }
+
+    ipc::storage_id_t acquire(chunk_info_t *info) {
+        IPC_UNUSED_ std::lock_guard<ipc::spin_lock> guard {mag_lock_};
+        if (mag_.slab() == nullptr) mag_.reset(&info->pool_);
+        ipc::storage_id_t id;
+        if (info->starving_.load(std::memory_order_relaxed)) {
+            // somebody ran out: take one at a time, until the pool has been refilled
+            mag_.flush();
+            id = info->pool_.acquire();
+        }
+        else id = mag_.acquire();
+        if ((id < 0) && (info->reclaim_dead() || info->reclaim_all())) {
+            id = info->pool_.acquire();
+        }
+        if (id < 0) {
+            info->starving_.store(true, std::memory_order_relaxed);
+        }
+        return id;
+    }
+
+    void release(chunk_info_t *info, ipc::storage_id_t id) {
+        if (info->starving_.load(std::memory_order_relaxed)) {
+            // somebody ran out: give everything back at once
+            info->pool_.release(id);
+            info->starving_.store(false, std::memory_order_relaxed);
+            IPC_UNUSED_ std::lock_guard<ipc::spin_lock> guard {mag_lock_};
+            mag_.flush();
+            return;
+        }
+        IPC_UNUSED_ std::lock_guard<ipc::spin_lock> guard {mag_lock_};
+        if (mag_.slab() == nullptr) mag_.reset(&info->pool_);
+        mag_.release(id);
+    }
+};
+
+auto& chunk_storages() {
     static ipc::map<std::size_t, chunk_handle_t> chunk_hs;
     return chunk_hs;
 }
 
-chunk_info_t *chunk_storage_info(std::size_t chunk_size) {
+chunk_handle_t *chunk_storage(std::size_t chunk_size) {
     auto &storages = chunk_storages();
     std::decay_t<decltype(storages)>::iterator it;
     {
         static ipc::rw_lock lock;
         IPC_UNUSED_ std::shared_lock<ipc::rw_lock> guard {lock};
         if ((it = storages.find(chunk_size)) == storages.end()) {
-            using chunk_handle_t = std::decay_t<decltype(storages)>::value_type::second_type;
             guard.unlock();
             IPC_UNUSED_ std::lock_guard<ipc::rw_lock> guard {lock};
-            it = storages.emplace(chunk_size, chunk_handle_t{}).first;
+            it = storages.try_emplace(chunk_size).first;
         }
     }
-    return it->second.get_info(chunk_size);
+    return &(it->second);
 }
 
-std::pair<ipc::storage_id_t, void*> acquire_storage(std::size_t size, ipc::circ::cc_t conns) {
+chunk_info_t *chunk_storage_info(std::size_t chunk_size) {
+    return chunk_storage(chunk_size)->get_info(chunk_size);
+}
+
+std::pair<storage_desc_t, void*> acquire_storage(std::size_t size, ipc::circ::cc_t conns) {
     std::size_t chunk_size = calc_chunk_size(size);
-    auto info = chunk_storage_info(chunk_size);
+    auto storage = chunk_storage(chunk_size);
+    auto info    = storage->get_info(chunk_size);
     if (info == nullptr) return {};
 
-    info->lock_.lock();
-    info->pool_.prepare();
     // got an unique id
-    auto id = info->pool_.acquire();
-    info->lock_.unlock();
+    auto id = storage->acquire(info);
 
     auto chunk = info->at(chunk_size, id);
     if (chunk == nullptr) return {};
-    chunk->conns().store(conns, std::memory_order_relaxed);
-    return { id, chunk->data() };
+    auto &head = chunk->head();
+    head.pubs_.store(1, std::memory_order_relaxed);
+    head.slots_.store((conns == 0) ? 0 : 1, std::memory_order_relaxed);
+    head.conns_[0].store(conns, std::memory_order_relaxed);
+    for (std::uint32_t k = 1; k < ipc::large_msg_fanout; ++k) {
+        head.conns_[k].store(0, std::memory_order_relaxed);
+    }
+    return { {id, 0}, chunk->data() };
 }
 
 void *find_storage(ipc::storage_id_t id, std::size_t size) {
@@ -196,23 +502,91 @@ void *find_storage(ipc::storage_id_t id, std::size_t size) {
     return info->at(chunk_size, id)->data();
 }
 
-void release_storage(ipc::storage_id_t id, std::size_t size) {
-    if (id < 0) {
-        ipc::error("[release_storage] id is invalid: id = %ld, size = %zd\n", (long)id, size);
+/// Starts loading the head of a chunk into the cache, before the user reads it.
+void prefetch_storage(void const * data, std::size_t size) {
+    constexpr std::size_t prefetch_size = 4096;
+    ipc::prefetch(data, (ipc::detail::min)(size, prefetch_size));
+}
+
+/// Returns the id of the chunk whose data is 'data', or -1 if it isn't in any chunk storage.
+ipc::storage_id_t find_storage_id(void const * data, std::size_t size) {
+    if ((data == nullptr) || (size <= ipc::large_msg_limit)) return -1;
+    std::size_t chunk_size = calc_chunk_size(size);
+    auto info = chunk_storage_info(chunk_size);
+    if (info == nullptr) return -1;
+    auto p   = static_cast<ipc::byte_t const *>(data) - chunk_head_size();
+    auto mem = info->chunks_mem();
+    if ((p < mem) || (p >= mem + chunk_info_t::chunks_mem_size(chunk_size))) return -1;
+    auto off = static_cast<std::size_t>(p - mem);
+    if ((off % chunk_size) != 0) return -1;
+    return static_cast<ipc::storage_id_t>(off / chunk_size);
+}
+
+/// Adds a publication to a chunk which the caller is holding.
+bool publish_storage(storage_desc_t & desc, std::size_t size, ipc::circ::cc_t conns) {
+    std::size_t chunk_size = calc_chunk_size(size);
+    auto info = chunk_storage_info(chunk_size);
+    if (info == nullptr) return false;
+    auto chunk = info->at(chunk_size, desc.id_);
+    if (chunk == nullptr) return false;
+    auto slot = chunk->publish(conns);
+    if (slot < 0) return false;
+    desc.slot_ = static_cast<std::uint32_t>(slot);
+    return true;
+}
+
+void release_storage(storage_desc_t const & desc, std::size_t size) {
+    if (desc.id_ < 0) {
+        ipc::error("[release_storage] id is invalid: id = %ld, size = %zd\n", (long)desc.id_, size);
+        return;
+    }
+    std::size_t chunk_size = calc_chunk_size(size);
+    auto storage = chunk_storage(chunk_size);
+    auto info    = storage->get_info(chunk_size);
+    if (info == nullptr) return;
+    auto chunk = info->at(chunk_size, desc.id_);
+    if ((desc.slot_ >= ipc::large_msg_fanout) || !chunk->unpublish(desc.slot_)) {
         return;
     }
+    storage->release(info, desc.id_);
+}
+
+void hold_storage(ipc::storage_id_t id, std::size_t size) {
     std::size_t chunk_size = calc_chunk_size(size);
     auto info = chunk_storage_info(chunk_size);
     if (info == nullptr) return;
-    info->lock_.lock();
-    info->pool_.release(id);
-    info->lock_.unlock();
+    auto chunk = info->at(chunk_size, id);
+    if (chunk == nullptr) return;
+    chunk->head().pubs_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void unhold_storage(ipc::storage_id_t id, std::size_t size) {
+    std::size_t chunk_size = calc_chunk_size(size);
+    auto storage = chunk_storage(chunk_size);
+    auto info    = storage->get_info(chunk_size);
+    if (info == nullptr) return;
+    auto chunk = info->at(chunk_size, id);
+    if ((chunk == nullptr) || !chunk->unhold()) {
+        return;
+    }
+    storage->release(info, id);
+}
+
+template <ipc::relat Rp, ipc::relat Rc>
+std::uint32_t count_rc(ipc::wr<Rp, Rc, ipc::trans::unicast>, ipc::circ::cc_t /*conns*/) noexcept {
+    return 1;
 }
 
+template <ipc::relat Rp, ipc::relat Rc>
+std::uint32_t count_rc(ipc::wr<Rp, Rc, ipc::trans::broadcast>, ipc::circ::cc_t conns) noexcept {
+    return static_cast<std::uint32_t>(std::bitset<sizeof(conns) * CHAR_BIT>(conns).count());
+}
+
+/// Returns true if this has taken the receivers down to none.
 template <ipc::relat Rp, ipc::relat Rc>
 bool sub_rc(ipc::wr<Rp, Rc, ipc::trans::unicast>, 
-            std::atomic<ipc::circ::cc_t> &/*conns*/, ipc::circ::cc_t /*curr_conns*/, ipc::circ::cc_t /*conn_id*/) noexcept {
-    return true;
+            std::atomic<ipc::circ::cc_t> &conns, ipc::circ::cc_t /*curr_conns*/, ipc::circ::cc_t /*conn_id*/) noexcept {
+    return conns.exchange(0, std::memory_order_acq_rel) != 0;
 }
 
 template <ipc::relat Rp, ipc::relat Rc>
@@ -221,64 +595,127 @@ bool sub_rc(ipc::wr<Rp, Rc, ipc::trans::broadcast>,
     auto last_conns = curr_conns & ~conn_id;
     for (unsigned k = 0;;) {
         auto chunk_conns  = conns.load(std::memory_order_acquire);
-        if (conns.compare_exchange_weak(chunk_conns, chunk_conns & last_conns, std::memory_order_release)) {
+        if (chunk_conns == 0) {
+            return false; // ended by someone else (see: release_storage)
+        }
+        if (conns.compare_exchange_weak(chunk_conns, chunk_conns & last_conns, std::memory_order_acq_rel)) {
             return (chunk_conns & last_conns) == 0;
         }
         ipc::yield(k);
     }
 }
 
+/// The receivers a remote_rec_t is waiting for: any one of them, or each of them.
+template <ipc::relat Rp, ipc::relat Rc>
+ipc::circ::cc_t owe_rc(ipc::wr<Rp, Rc, ipc::trans::unicast>, ipc::circ::cc_t /*conns*/) noexcept {
+    return 1;
+}
+
+template <ipc::relat Rp, ipc::relat Rc>
+ipc::circ::cc_t owe_rc(ipc::wr<Rp, Rc, ipc::trans::broadcast>, ipc::circ::cc_t conns) noexcept {
+    return conns;
+}
+
+template <ipc::relat Rp, ipc::relat Rc>
+void paid_rc(ipc::wr<Rp, Rc, ipc::trans::unicast>, 
+             std::atomic<ipc::circ::cc_t> &owed, ipc::circ::cc_t /*conn_id*/) noexcept {
+    owed.store(0, std::memory_order_release);
+}
+
+template <ipc::relat Rp, ipc::relat Rc>
+void paid_rc(ipc::wr<Rp, Rc, ipc::trans::broadcast>, 
+             std::atomic<ipc::circ::cc_t> &owed, ipc::circ::cc_t conn_id) noexcept {
+    owed.fetch_and(~conn_id, std::memory_order_acq_rel);
+}
+
+/// Returns true if any receiver still connected hasn't done with a remote_rec_t.
+template <ipc::relat Rp, ipc::relat Rc>
+bool owing_rc(ipc::wr<Rp, Rc, ipc::trans::unicast>, ipc::circ::cc_t owed, ipc::circ::cc_t curr_conns) noexcept {
+    return (owed != 0) && (curr_conns != 0);
+}
+
+template <ipc::relat Rp, ipc::relat Rc>
+bool owing_rc(ipc::wr<Rp, Rc, ipc::trans::broadcast>, ipc::circ::cc_t owed, ipc::circ::cc_t curr_conns) noexcept {
+    return (owed & curr_conns) != 0;
+}
+
 template <typename Flag>
-void recycle_storage(ipc::storage_id_t id, std::size_t size, ipc::circ::cc_t curr_conns, ipc::circ::cc_t conn_id) {
-    if (id < 0) {
-        ipc::error("[recycle_storage] id is invalid: id = %ld, size = %zd\n", (long)id, size);
+void recycle_storage(storage_desc_t const & desc, std::size_t size, ipc::circ::cc_t curr_conns, ipc::circ::cc_t conn_id) {
+    if ((desc.id_ < 0) || (desc.slot_ >= ipc::large_msg_fanout)) {
+        ipc::error("[recycle_storage] id is invalid: id = %ld, slot = %u, size = %zd\n", 
+                   (long)desc.id_, (unsigned)desc.slot_, size);
         return;
     }
     std::size_t chunk_size = calc_chunk_size(size);
-    auto info = chunk_storage_info(chunk_size);
+    auto storage = chunk_storage(chunk_size);
+    auto info    = storage->get_info(chunk_size);
     if (info == nullptr) return;
 
-    auto chunk = info->at(chunk_size, id);
+    auto chunk = info->at(chunk_size, desc.id_);
     if (chunk == nullptr) return;
 
-    if (!sub_rc(Flag{}, chunk->conns(), curr_conns, conn_id)) {
+    if (!sub_rc(Flag{}, chunk->conns(desc.slot_), curr_conns, conn_id)) {
         return;
     }
-    info->lock_.lock();
-    info->pool_.release(id);
-    info->lock_.unlock();
+    if (!chunk->release_slot(desc.slot_)) {
+        return;
+    }
+    storage->release(info, desc.id_);
 }
 
 template <typename MsgT>
 bool clear_message(void* p) {
     auto msg = static_cast<MsgT*>(p);
+    if (msg->storage_ && (msg->storage_desc().slot_ & remote_slot_flag)) {
+        // the sender would time out, since the receivers never get it
+        storage_desc_t desc = msg->storage_desc();
+        desc.slot_ &= ~remote_slot_flag;
+        release_storage(desc, sizeof(remote_rec_t));
+        return true;
+    }
     if (msg->storage_) {
-        std::int32_t r_size = static_cast<std::int32_t>(ipc::data_length) + msg->remain_;
-        if (r_size <= 0) {
-            ipc::error("[clear_message] invalid msg size: %d\n", (int)r_size);
+        auto r_size = msg->rest();
+        if (r_size == 0) {
+            ipc::error("[clear_message] invalid msg size: %u\n", (unsigned)r_size);
             return true;
         }
-        release_storage(
-            *reinterpret_cast<ipc::storage_id_t*>(&msg->data_),
-            static_cast<std::size_t>(r_size));
+        release_storage(msg->storage_desc(), static_cast<std::size_t>(r_size));
     }
     return true;
 }
 
-struct conn_info_head {
+struct conn_info_head : ipc::detail::chan_head {
 
-    ipc::string name_;
-    msg_id_t    cc_id_; // connection-info id
+    ipc::string   name_;
+    std::uint16_t cc_id_ = 0; // connection-info id, see: conn_acc_t
+    bool          spin_  = false; // see: ipc::spin
     ipc::detail::waiter cc_waiter_, wt_waiter_, rd_waiter_;
     ipc::shm::handle acc_h_;
 
-    conn_info_head(char const * name)
-        : name_     {name}
-        , cc_id_    {(cc_acc() == nullptr) ? 0 : cc_acc()->fetch_add(1, std::memory_order_relaxed)}
-        , cc_waiter_{("__CC_CONN__" + name_).c_str()}
-        , wt_waiter_{("__WT_CONN__" + name_).c_str()}
-        , rd_waiter_{("__RD_CONN__" + name_).c_str()}
-        , acc_h_    {("__AC_CONN__" + name_).c_str(), sizeof(acc_t)} {
+    conn_info_head(char const * name, bool prio_inherit)
+        : chan_head {false}
+        , name_     {name}
+        , cc_waiter_{("__CC_CONN__" + name_).c_str(), prio_inherit}
+        , wt_waiter_{("__WT_CONN__" + name_).c_str(), prio_inherit}
+        , rd_waiter_{("__RD_CONN__" + name_).c_str(), prio_inherit}
+        , acc_h_    {("__AC_CONN__" + name_).c_str(), sizeof(conn_acc_t)} {
+        auto cc = static_cast<conn_acc_t*>(acc_h_.get());
+        if (cc != nullptr) cc_id_ = cc->claim();
+    }
+
+    ~conn_info_head() {
+        auto cc = static_cast<conn_acc_t*>(acc_h_.get());
+        if (cc != nullptr) cc->unclaim(cc_id_);
+    }
+
+    /// The waiters fail to open if the channel is in use with another sync backend.
+    bool waiters_valid() const noexcept {
+        return cc_waiter_.valid() && wt_waiter_.valid() && rd_waiter_.valid();
+    }
+
+    /// Fails if there are already conn_acc_t::max_conns connections on the channel.
+    bool cc_id_valid() const noexcept {
+        return cc_id_ != 0;
     }
 
     void quit_waiting() {
@@ -287,13 +724,16 @@ struct conn_info_head {
         rd_waiter_.quit_waiting();
     }
 
-    auto acc() {
-        return static_cast<acc_t*>(acc_h_.get());
+    acc_t *acc() {
+        auto cc = static_cast<conn_acc_t*>(acc_h_.get());
+        return (cc == nullptr) ? nullptr : &(cc->msg_acc_);
     }
 
-    auto& recv_cache() {
-        thread_local ipc::unordered_map<msg_id_t, cache_t> tls;
-        return tls;
+    // a connection is received by one thread at a time (see: queue_base::cursor_)
+    recv_cache_t recv_cache_;
+
+    recv_cache_t & recv_cache() noexcept {
+        return recv_cache_;
     }
 };
 
@@ -312,9 +752,32 @@ bool wait_for(W& waiter, F&& pred, std::uint64_t tm) {
     return true;
 }
 
+/**
+ * Polls until 'pred' succeeds, for ipc::spin receivers: never sleeps in the kernel,
+ * but parks the cpu between the polls on the word 'addr()' gives (see: monitor_wait),
+ * which is asked again every time, as the one a sender commits to moves with the ring.
+*/
+template <typename W, typename A, typename F>
+bool spin_for(W& waiter, A&& addr, F&& pred, std::uint64_t tm) {
+    if (tm == 0) return pred();
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned k = 1;; ++k) {
+        if (ipc::detail::monitor_wait(addr(), pred)) return true;
+        if ((k % 64) != 0) continue;
+        if (waiter.quitting()) return false;
+        if ((tm != ipc::invalid_value) &&
+            (static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start).count()) >= tm)) {
+            return false;
+        }
+        // let the others have the cpu if it is overcommitted
+        std::this_thread::yield();
+    }
+}
+
 template <typename Policy,
           std::size_t DataSize  = ipc::data_length,
-          std::size_t AlignSize = (ipc::detail::min)(DataSize, alignof(std::max_align_t))>
+          std::size_t AlignSize = alignof(std::uint64_t)>
 struct queue_generator {
 
     using queue_t = ipc::queue<msg_t<DataSize, AlignSize>, Policy>;
@@ -322,8 +785,8 @@ struct queue_generator {
     struct conn_info_t : conn_info_head {
         queue_t que_;
 
-        conn_info_t(char const * name)
-            : conn_info_head{name}
+        conn_info_t(char const * name, bool prio_inherit)
+            : conn_info_head{name, prio_inherit}
             , que_{("__QU_CONN__" +
                     ipc::to_string(DataSize) + "__" +
                     ipc::to_string(AlignSize) + "__" + name).c_str()} {
@@ -389,10 +852,21 @@ static bool reconnect(ipc::handle_t * ph, bool start_to_recv) {
     return que->ready_sending();
 }
 
-static bool connect(ipc::handle_t * ph, char const * name, bool start_to_recv) {
+static bool connect(ipc::handle_t * ph, char const * name, bool start_to_recv, bool prio_inherit) {
     assert(ph != nullptr);
     if (*ph == nullptr) {
-        *ph = ipc::mem::alloc<conn_info_t>(name);
+        auto info = ipc::mem::alloc<conn_info_t>(name, prio_inherit);
+        if (!info->waiters_valid()) {
+            ipc::error("fail: connect(%s), the waiters of the channel cannot be opened.\n", name);
+            ipc::mem::free(info);
+            return false;
+        }
+        if (!info->cc_id_valid()) {
+            ipc::error("fail: connect(%s), too many connections on the channel.\n", name);
+            ipc::mem::free(info);
+            return false;
+        }
+        *ph = info;
     }
     return reconnect(ph, start_to_recv);
 }
@@ -420,13 +894,14 @@ static bool wait_for_recv(ipc::handle_t h, std::size_t r_count, std::uint64_t tm
     }, tm);
 }
 
-template <typename F>
-static bool send(F&& gen_push, ipc::handle_t h, void const * data, std::size_t size) {
+/// Checks the connection, then gets the receivers & a new message id for sending.
+static bool prepare_send(ipc::handle_t h, void const * data, std::size_t size, 
+                         queue_t *& que, ipc::circ::cc_t & conns, msg_id_t & msg_id) {
     if (data == nullptr || size == 0) {
         ipc::error("fail: send(%p, %zd)\n", data, size);
         return false;
     }
-    auto que = queue_of(h);
+    que = queue_of(h);
     if (que == nullptr) {
         ipc::error("fail: send, queue_of(h) == nullptr\n");
         return false;
@@ -439,7 +914,7 @@ static bool send(F&& gen_push, ipc::handle_t h, void const * data, std::size_t s
         ipc::error("fail: send, que->ready_sending() == false\n");
         return false;
     }
-    ipc::circ::cc_t conns = que->elems()->connections(std::memory_order_relaxed);
+    conns = que->elems()->connections(std::memory_order_relaxed);
     if (conns == 0) {
         ipc::error("fail: send, there is no receiver on this connection.\n");
         return false;
@@ -450,77 +925,306 @@ static bool send(F&& gen_push, ipc::handle_t h, void const * data, std::size_t s
         ipc::error("fail: send, info_of(h)->acc() == nullptr\n");
         return false;
     }
-    auto msg_id   = acc->fetch_add(1, std::memory_order_relaxed);
+    msg_id = acc->fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+/**
+ * Sends a message with 'try_push(tag, rest, data, size)' (see: msg_t),
+ * in a chunk if it is large, or else in as many fragments as it takes.
+*/
+template <typename F>
+static bool send(F&& gen_push, ipc::handle_t h, void const * data, std::size_t size, 
+                 ipc::storage_id_t relay_id = -1, std::uint32_t tag = 0) {
+    queue_t *       que;
+    ipc::circ::cc_t conns;
+    msg_id_t        msg_id;
+    if (!prepare_send(h, data, size, que, conns, msg_id)) {
+        return false;
+    }
+    if (size > max_msg_size) {
+        ipc::error("fail: send, the message is too large: %zd\n", size);
+        return false;
+    }
     auto try_push = std::forward<F>(gen_push)(info_of(h), que, msg_id);
     if (size > ipc::large_msg_limit) {
+        if (relay_id >= 0) {
+            // publish the chunk which holds the data once more, without copying
+            storage_desc_t desc {relay_id, 0};
+            if (publish_storage(desc, size, conns)) {
+                if (try_push(tag, static_cast<std::uint32_t>(size), &desc, 0)) {
+                    return true;
+                }
+                release_storage(desc, size);
+                return false;
+            }
+            // all slots of the chunk are in use, copy it
+        }
         auto   dat = acquire_storage(size, conns);
         void * buf = dat.second;
         if (buf != nullptr) {
             std::memcpy(buf, data, size);
-            return try_push(static_cast<std::int32_t>(size) - 
-                            static_cast<std::int32_t>(ipc::data_length), &(dat.first), 0);
+            if (try_push(tag, static_cast<std::uint32_t>(size), &(dat.first), 0)) {
+                return true;
+            }
+            release_storage(dat.first, size);
+            return false;
         }
         // try using message fragment
         //ipc::log("fail: shm::handle for big message. msg_id: %zd, size: %zd\n", msg_id, size);
     }
-    // push message fragment
-    std::int32_t offset = 0;
-    for (std::int32_t i = 0; i < static_cast<std::int32_t>(size / ipc::data_length); ++i, offset += ipc::data_length) {
-        if (!try_push(static_cast<std::int32_t>(size) - offset - static_cast<std::int32_t>(ipc::data_length),
-                      static_cast<ipc::byte_t const *>(data) + offset, ipc::data_length)) {
+    // push message fragments, all but the last one tell the bytes left
+    std::size_t last = ipc::data_length - queue_t::value_t::prefix_size(tag != 0, false);
+    std::size_t step = ipc::data_length - queue_t::value_t::prefix_size(tag != 0, true);
+    std::size_t offset = 0;
+    for (; (size - offset) > last; offset += step) {
+        if (!try_push(tag, static_cast<std::uint32_t>(size - offset),
+                      static_cast<ipc::byte_t const *>(data) + offset, step)) {
             return false;
         }
     }
-    // if remain > 0, this is the last message fragment
-    std::int32_t remain = static_cast<std::int32_t>(size) - offset;
-    if (remain > 0) {
-        if (!try_push(remain - static_cast<std::int32_t>(ipc::data_length),
-                      static_cast<ipc::byte_t const *>(data) + offset, 
-                      static_cast<std::size_t>(remain))) {
-            return false;
-        }
+    return try_push(tag, static_cast<std::uint32_t>(size - offset),
+                    static_cast<ipc::byte_t const *>(data) + offset, size - offset);
+}
+
+/// Wakes up the receivers for a new message: all of them if broadcast, or just one.
+template <typename Info>
+static void notify_recv(Info * info) {
+    if (ipc::relat_trait<flag_t>::is_broadcast) {
+        info->rd_waiter_.broadcast();
     }
-    return true;
+    else info->rd_waiter_.notify();
 }
 
-static bool send(ipc::handle_t h, void const * data, std::size_t size, std::uint64_t tm) {
-    return send([tm](auto info, auto que, auto msg_id) {
-        return [tm, info, que, msg_id](std::int32_t remain, void const * data, std::size_t size) {
+static auto send_push(std::uint64_t tm) {
+    return [tm](auto info, auto que, auto msg_id) {
+        return [tm, info, que, msg_id](std::uint32_t tag, std::uint32_t rest, void const * data, std::size_t size) {
             if (!wait_for(info->wt_waiter_, [&] {
                     return !que->push(
                         [](void*) { return true; },
-                        info->cc_id_, msg_id, remain, data, size);
+                        info->cc_id_, msg_id, tag, rest, data, size);
                 }, tm)) {
-                ipc::log("force_push: msg_id = %zd, remain = %d, size = %zd\n", msg_id, remain, size);
+                ipc::log("force_push: msg_id = %zd, rest = %u, size = %zd\n", msg_id, (unsigned)rest, size);
                 if (!que->force_push(
                         clear_message<typename queue_t::value_t>,
-                        info->cc_id_, msg_id, remain, data, size)) {
+                        info->cc_id_, msg_id, tag, rest, data, size)) {
                     return false;
                 }
             }
-            info->rd_waiter_.broadcast();
+            notify_recv(info);
             return true;
         };
-    }, h, data, size);
+    };
+}
+
+static bool send(ipc::handle_t h, void const * data, std::size_t size, std::uint64_t tm) {
+    return send(send_push(tm), h, data, size);
+}
+
+static bool send_tagged(ipc::handle_t h, std::uint32_t tag, void const * data, std::size_t size, std::uint64_t tm) {
+    return send(send_push(tm), h, data, size, -1, tag);
+}
+
+static bool relay(ipc::handle_t h, ipc::buff_t const & buff, std::uint64_t tm) {
+    return send(send_push(tm), h, buff.data(), buff.size(), find_storage_id(buff.data(), buff.size()));
+}
+
+static bool send_remote(ipc::handle_t h, void const * data, std::size_t size, std::uint64_t tm) {
+#if defined(IPC_OS_LINUX_)
+    if (size <= ipc::large_msg_limit) {
+        return send(h, data, size, tm);
+    }
+    return send_remote(h, data, -1, size, tm);
+#else
+    IPC_UNUSED_ auto unused = std::make_tuple(h, data, size, tm);
+    ipc::error("fail: send_remote, process_vm_readv is only available on Linux.\n");
+    return false;
+#endif
+}
+
+static bool send_memfd(ipc::handle_t h, int fd, std::size_t size, std::uint64_t tm) {
+#if defined(IPC_OS_LINUX_)
+    if (fd < 0) {
+        ipc::error("fail: send_memfd, invalid fd: %d\n", fd);
+        return false;
+    }
+    // the receivers would check it too, fail here rather than in each of them
+    if (!ipc::detail::check_sealed_memfd(fd, size)) {
+        return false;
+    }
+    // pass a non-null pointer for the checks in prepare_send
+    return send_remote(h, &fd, fd, size, tm);
+#else
+    IPC_UNUSED_ auto unused = std::make_tuple(h, fd, size, tm);
+    ipc::error("fail: send_memfd, memfd is only available on Linux.\n");
+    return false;
+#endif
+}
+
+static bool send_memfd(ipc::handle_t h, void const * data, std::size_t size, std::uint64_t tm) {
+#if defined(IPC_OS_LINUX_)
+    int fd = ipc::detail::make_sealed_memfd(data, size);
+    if (fd < 0) return false;
+    IPC_UNUSED_ auto finally = ipc::guard([fd] {
+        ipc::detail::close_fd(fd);
+    });
+    return send_memfd(h, fd, size, tm);
+#else
+    IPC_UNUSED_ auto unused = std::make_tuple(h, data, size, tm);
+    ipc::error("fail: send_memfd, memfd is only available on Linux.\n");
+    return false;
+#endif
+}
+
+#if defined(IPC_OS_LINUX_)
+/// Publishes a remote_rec_t, then waits for all receivers have done with it.
+static bool send_remote(ipc::handle_t h, void const * data, int fd, std::size_t size, std::uint64_t tm) {
+    queue_t *       que;
+    ipc::circ::cc_t conns;
+    msg_id_t        msg_id;
+    if (!prepare_send(h, data, size, que, conns, msg_id)) {
+        return false;
+    }
+    auto dat = acquire_storage(sizeof(remote_rec_t), conns);
+    auto rec = static_cast<remote_rec_t *>(dat.second);
+    if (rec == nullptr) {
+        // no chunk for the record, copy it as usual
+        if (fd < 0) return send(h, data, size, tm);
+        ipc::error("fail: send_memfd, no chunk for the record.\n");
+        return false;
+    }
+    rec->pid_  = ipc::detail::current_pid();
+    rec->fd_   = fd;
+    rec->addr_ = reinterpret_cast<std::uintptr_t>(data);
+    rec->size_ = size;
+    rec->pending_.store(owe_rc(flag_t{}, conns), std::memory_order_relaxed);
+    rec->state_  .store(0, std::memory_order_relaxed);
+    // keep the record until we have done with it
+    hold_storage(dat.first.id_, sizeof(remote_rec_t));
+    IPC_UNUSED_ auto finally = ipc::guard([&dat] {
+        unhold_storage(dat.first.id_, sizeof(remote_rec_t));
+    });
+
+    storage_desc_t desc = dat.first;
+    desc.slot_ |= remote_slot_flag;
+    auto info = info_of(h);
+    // the receivers take the real size from the record
+    if (!send_push(tm)(info, que, msg_id)(0, static_cast<std::uint32_t>((ipc::detail::min)(size, max_msg_size)), 
+                                          &desc, 0)) {
+        release_storage(dat.first, sizeof(remote_rec_t));
+        return false;
+    }
+    // the data must stay valid until all receivers have copied it,
+    // a receiver which has disconnected meanwhile is not waited for (disconnecting wakes us)
+    if (!wait_for(info->wt_waiter_, [rec, que] {
+            return owing_rc(flag_t{}, rec->pending_.load(std::memory_order_acquire), 
+                                      que->elems()->connections(std::memory_order_acquire));
+        }, tm)) {
+        rec->state_.fetch_or(remote_cancelled, std::memory_order_acq_rel);
+        ipc::log("fail: send_remote, timeout: msg_id = %zd, size = %zd\n", msg_id, size);
+        return false;
+    }
+    return (rec->state_.load(std::memory_order_acquire) & remote_failed) == 0;
+}
+#endif // IPC_OS_LINUX_
+
+/// Copies (or maps) the data of a message sent by send_remote/send_memfd, and tells the sender.
+static ipc::buff_t recv_remote(ipc::handle_t h, storage_desc_t desc, bool skip) {
+    auto que = queue_of(h);
+    desc.slot_ &= ~remote_slot_flag;
+    auto rec = static_cast<remote_rec_t *>(find_storage(desc.id_, sizeof(remote_rec_t)));
+    if (rec == nullptr) {
+        // the sender waits until we disconnect, or its timeout
+        ipc::error("fail: recv, no remote record: id = %ld\n", (long)desc.id_);
+        return {};
+    }
+    ipc::buff_t buff;
+    if (!skip && ((rec->state_.load(std::memory_order_acquire) & remote_cancelled) == 0)) {
+#if defined(IPC_OS_LINUX_)
+        auto msg_size = static_cast<std::size_t>(rec->size_);
+        if (rec->fd_ >= 0) {
+            // map the memfd of the sender, no copy at all
+            int fd = ipc::detail::dup_remote_fd(rec->pid_, rec->fd_);
+            // never trust the sender: an unsealed memfd could be changed or truncated under the mapping
+            void *mem = ((fd < 0) || !ipc::detail::check_sealed_memfd(fd, msg_size)) ? 
+                        nullptr : ipc::detail::map_memfd(fd, msg_size);
+            if (fd >= 0) ipc::detail::close_fd(fd);
+            if (mem == nullptr) {
+                rec->state_.fetch_or(remote_failed, std::memory_order_relaxed);
+                ipc::error("fail: recv, cannot map the memfd of pid %d\n", (int)rec->pid_);
+            }
+            else buff = ipc::buff_t{mem, msg_size, [](void *p, std::size_t size) {
+                ipc::detail::unmap_memfd(p, size);
+            }};
+        } else {
+            void *buf = ipc::mem::alloc(msg_size);
+            if (!ipc::detail::read_remote_mem(rec->pid_, rec->addr_, buf, msg_size)) {
+                rec->state_.fetch_or(remote_failed, std::memory_order_relaxed);
+                ipc::error("fail: recv, cannot read the memory of pid %d\n", (int)rec->pid_);
+                ipc::mem::free(buf, msg_size);
+            }
+            // the sender might have given up while copying
+            else if (rec->state_.load(std::memory_order_acquire) & remote_cancelled) {
+                ipc::mem::free(buf, msg_size);
+            }
+            else buff = ipc::buff_t{buf, msg_size, ipc::mem::free};
+        }
+#else
+        rec->state_.fetch_or(remote_failed, std::memory_order_relaxed);
+#endif
+    }
+    paid_rc(flag_t{}, rec->pending_, que->connected_id());
+    recycle_storage<flag_t>(desc, sizeof(remote_rec_t), 
+                            que->elems()->connections(std::memory_order_relaxed), que->connected_id());
+    info_of(h)->wt_waiter_.broadcast();
+    return buff;
+}
+
+static bool publish_all(ipc::handle_t const * hs, std::size_t n, void const * data, std::size_t size, std::uint64_t tm) {
+    if ((hs == nullptr) || (n == 0)) return false;
+    void const *          buf = data;
+    std::pair<storage_desc_t, void*> dat {};
+    if ((n > 1) && (size > ipc::large_msg_limit) && (data != nullptr)) {
+        // copy once, and hold the chunk (its slot 0 is left free) until every channel has got it
+        dat = acquire_storage(size, 0);
+        if (dat.second != nullptr) {
+            std::memcpy(dat.second, data, size);
+            buf = dat.second;
+        }
+    }
+    bool ret = true;
+    for (std::size_t i = 0; i < n; ++i) {
+        ret = send(send_push(tm), hs[i], buf, size, 
+                   (dat.second == nullptr) ? -1 : dat.first.id_) && ret;
+    }
+    if (dat.second != nullptr) {
+        unhold_storage(dat.first.id_, size);
+    }
+    return ret;
 }
 
 static bool try_send(ipc::handle_t h, void const * data, std::size_t size, std::uint64_t tm) {
     return send([tm](auto info, auto que, auto msg_id) {
-        return [tm, info, que, msg_id](std::int32_t remain, void const * data, std::size_t size) {
+        return [tm, info, que, msg_id](std::uint32_t tag, std::uint32_t rest, void const * data, std::size_t size) {
             if (!wait_for(info->wt_waiter_, [&] {
                     return !que->push(
                         [](void*) { return true; },
-                        info->cc_id_, msg_id, remain, data, size);
+                        info->cc_id_, msg_id, tag, rest, data, size);
                 }, tm)) {
                 return false;
             }
-            info->rd_waiter_.broadcast();
+            notify_recv(info);
             return true;
         };
     }, h, data, size);
 }
 
-static ipc::buff_t recv(ipc::handle_t h, std::uint64_t tm) {
+/**
+ * Receives the next message, skipping those 'accept' refuses by their tag (if not null),
+ * before copying or mapping any data of them. The skipped messages don't extend 'tm'.
+*/
+static ipc::buff_t recv(ipc::handle_t h, std::uint64_t tm, 
+                        ipc::tag_filter_t accept = nullptr, void const * ctx = nullptr, std::uint32_t * tag = nullptr) {
     auto que = queue_of(h);
     if (que == nullptr) {
         ipc::error("fail: recv, queue_of(h) == nullptr\n");
@@ -531,37 +1235,68 @@ static ipc::buff_t recv(ipc::handle_t h, std::uint64_t tm) {
         return {};
     }
     auto& rc = info_of(h)->recv_cache();
+    auto start = std::chrono::steady_clock::now();
     for (;;) {
+        std::uint64_t left = tm;
+        if ((tm != 0) && (tm != ipc::invalid_value)) {
+            auto spent = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                             std::chrono::steady_clock::now() - start).count());
+            left = (spent >= tm) ? 0 : (tm - spent);
+        }
         // pop a new message
         typename queue_t::value_t msg;
-        if (!wait_for(info_of(h)->rd_waiter_, [que, &msg] {
+        bool popped = info_of(h)->spin_ ?
+            spin_for(info_of(h)->rd_waiter_, [que] { return que->commit_addr(); }, [que, &msg] {
+                return que->pop(msg);
+            }, left) :
+            wait_for(info_of(h)->rd_waiter_, [que, &msg] {
                 return !que->pop(msg);
-            }, tm)) {
+            }, left);
+        if (!popped) {
             // pop failed, just return.
             return {};
         }
         info_of(h)->wt_waiter_.broadcast();
-        if ((info_of(h)->acc() != nullptr) && (msg.cc_id_ == info_of(h)->cc_id_)) {
+        bool to_self = (info_of(h)->acc() != nullptr) && (msg.cc_id_ == info_of(h)->cc_id_);
+        bool skip    = to_self || ((accept != nullptr) && !accept(ctx, msg.tag()));
+        // the size of the message, or of what is left of it from this fragment on
+        std::size_t msg_size = msg.rest();
+        if ((msg_size == 0) || (!msg.storage_ && (msg.size_ > ipc::data_length))) {
+            ipc::error("fail: recv, msg size = %zd, fragment size = %u\n", msg_size, (unsigned)msg.size_);
+            return {};
+        }
+        // the data is in the sender's memory
+        if (msg.storage_ && (msg.storage_desc().slot_ & remote_slot_flag)) {
+            auto buff = recv_remote(h, msg.storage_desc(), skip);
+            if (buff.empty()) continue;
+            if (tag != nullptr) *tag = msg.tag();
+            return buff;
+        }
+        if (to_self) {
             continue; // ignore message to self
         }
-        // msg.remain_ may minus & abs(msg.remain_) < data_length
-        std::int32_t r_size = static_cast<std::int32_t>(ipc::data_length) + msg.remain_;
-        if (r_size <= 0) {
-            ipc::error("fail: recv, r_size = %d\n", (int)r_size);
-            return {};
+        if (skip) {
+            // not wanted, give our share of the chunk back untouched
+            if (msg.storage_) {
+                recycle_storage<flag_t>(msg.storage_desc(), msg_size, 
+                                        que->elems()->connections(std::memory_order_relaxed), que->connected_id());
+            }
+            continue;
         }
-        std::size_t msg_size = static_cast<std::size_t>(r_size);
+        if (tag != nullptr) *tag = msg.tag();
         // large message
         if (msg.storage_) {
-            ipc::storage_id_t buf_id = *reinterpret_cast<ipc::storage_id_t*>(&msg.data_);
+            storage_desc_t buf_desc = msg.storage_desc();
+            ipc::storage_id_t buf_id = buf_desc.id_;
             void* buf = find_storage(buf_id, msg_size);
             if (buf != nullptr) {
+                prefetch_storage(buf, msg_size);
                 struct recycle_t {
-                    ipc::storage_id_t storage_id;
-                    ipc::circ::cc_t   curr_conns;
-                    ipc::circ::cc_t   conn_id;
+                    storage_desc_t  storage_desc;
+                    ipc::circ::cc_t curr_conns;
+                    ipc::circ::cc_t conn_id;
                 } *r_info = ipc::mem::alloc<recycle_t>(recycle_t{
-                    buf_id, que->elems()->connections(std::memory_order_relaxed), que->connected_id()
+                    buf_desc, que->elems()->connections(std::memory_order_relaxed), que->connected_id()
                 });
                 if (r_info == nullptr) {
                     ipc::log("fail: ipc::mem::alloc<recycle_t>.\n");
@@ -572,7 +1307,7 @@ static ipc::buff_t recv(ipc::handle_t h, std::uint64_t tm) {
                         IPC_UNUSED_ auto finally = ipc::guard([r_info] {
                             ipc::mem::free(r_info);
                         });
-                        recycle_storage<flag_t>(r_info->storage_id, size, r_info->curr_conns, r_info->conn_id);
+                        recycle_storage<flag_t>(r_info->storage_desc, size, r_info->curr_conns, r_info->conn_id);
                     }, r_info};
                 }
             } else {
@@ -581,38 +1316,26 @@ static ipc::buff_t recv(ipc::handle_t h, std::uint64_t tm) {
             }
         }
         // find cache with msg.id_
-        auto cac_it = rc.find(msg.id_);
-        if (cac_it == rc.end()) {
-            if (msg_size <= ipc::data_length) {
-                return make_cache(msg.data_, msg_size);
-            }
-            // gc
-            if (rc.size() > 1024) {
-                std::vector<msg_id_t> need_del;
-                for (auto const & pair : rc) {
-                    auto cmp = std::minmax(msg.id_, pair.first);
-                    if (cmp.second - cmp.first > 8192) {
-                        need_del.push_back(pair.first);
-                    }
-                }
-                for (auto id : need_del) rc.erase(id);
+        rc.expire(msg.id_);
+        auto cac_it = rc.parts_.find(msg.id_);
+        if (cac_it == rc.parts_.end()) {
+            if (!msg.more_) {
+                return make_cache(msg.data(), msg.size_, msg.size_);
             }
             // cache the first message fragment
-            rc.emplace(msg.id_, cache_t { ipc::data_length, make_cache(msg.data_, msg_size) });
+            rc.parts_.emplace(msg.id_, cache_t { msg.size_, make_cache(msg.data(), msg.size_, msg_size) });
         }
         // has cached before this message
         else {
             auto& cac = cac_it->second;
+            cac.append(msg.data(), msg.size_);
             // this is the last message fragment
-            if (msg.remain_ <= 0) {
-                cac.append(&(msg.data_), msg_size);
+            if (!msg.more_) {
                 // finish this message, erase it from cache
                 auto buff = std::move(cac.buff_);
-                rc.erase(cac_it);
+                rc.parts_.erase(cac_it);
                 return buff;
             }
-            // there are remain datas after this message
-            cac.append(&(msg.data_), ipc::data_length);
         }
     }
 }
@@ -626,6 +1349,9 @@ static ipc::buff_t try_recv(ipc::handle_t h) {
 template <typename Flag>
 using policy_t = ipc::policy::choose<ipc::circ::elem_array, Flag>;
 
+template <typename Flag>
+using local_t = ipc::detail::local_chan<Flag>;
+
 } // internal-linkage
 
 namespace ipc {
@@ -638,57 +1364,177 @@ ipc::handle_t chan_impl<Flag>::inited() {
 
 template <typename Flag>
 bool chan_impl<Flag>::connect(ipc::handle_t * ph, char const * name, unsigned mode) {
-    return detail_impl<policy_t<Flag>>::connect(ph, name, mode & receiver);
+    bool local = (mode & ipc::local) != 0;
+    if ((*ph != nullptr) && (ipc::detail::is_local(*ph) != local)) {
+        // switching between in-process & cross-process
+        destroy(*ph);
+        *ph = nullptr;
+    }
+    if (local) {
+        return local_t<Flag>::connect(ph, name, mode & receiver);
+    }
+    if (!detail_impl<policy_t<Flag>>::connect(ph, name, mode & receiver, (mode & ipc::prio_inherit) != 0)) {
+        return false;
+    }
+    static_cast<conn_info_head *>(*ph)->spin_ = (mode & ipc::spin) != 0;
+    return true;
 }
 
 template <typename Flag>
 bool chan_impl<Flag>::reconnect(ipc::handle_t * ph, unsigned mode) {
-    return detail_impl<policy_t<Flag>>::reconnect(ph, mode & receiver);
+    if (ipc::detail::is_local(*ph)) {
+        return local_t<Flag>::reconnect(ph, mode & receiver);
+    }
+    if (!detail_impl<policy_t<Flag>>::reconnect(ph, mode & receiver)) {
+        return false;
+    }
+    static_cast<conn_info_head *>(*ph)->spin_ = (mode & ipc::spin) != 0;
+    return true;
 }
 
 template <typename Flag>
 void chan_impl<Flag>::disconnect(ipc::handle_t h) {
+    if (ipc::detail::is_local(h)) {
+        local_t<Flag>::disconnect(h);
+        return;
+    }
     detail_impl<policy_t<Flag>>::disconnect(h);
 }
 
 template <typename Flag>
 void chan_impl<Flag>::destroy(ipc::handle_t h) {
+    if (ipc::detail::is_local(h)) {
+        local_t<Flag>::destroy(h);
+        return;
+    }
     detail_impl<policy_t<Flag>>::destroy(h);
 }
 
 template <typename Flag>
 char const * chan_impl<Flag>::name(ipc::handle_t h) {
+    if (ipc::detail::is_local(h)) {
+        return local_t<Flag>::name(h);
+    }
     auto info = detail_impl<policy_t<Flag>>::info_of(h);
     return (info == nullptr) ? nullptr : info->name_.c_str();
 }
 
 template <typename Flag>
 std::size_t chan_impl<Flag>::recv_count(ipc::handle_t h) {
+    if (ipc::detail::is_local(h)) {
+        return local_t<Flag>::recv_count(h);
+    }
     return detail_impl<policy_t<Flag>>::recv_count(h);
 }
 
 template <typename Flag>
 bool chan_impl<Flag>::wait_for_recv(ipc::handle_t h, std::size_t r_count, std::uint64_t tm) {
+    if (ipc::detail::is_local(h)) {
+        return local_t<Flag>::wait_for_recv(h, r_count, tm);
+    }
     return detail_impl<policy_t<Flag>>::wait_for_recv(h, r_count, tm);
 }
 
 template <typename Flag>
 bool chan_impl<Flag>::send(ipc::handle_t h, void const * data, std::size_t size, std::uint64_t tm) {
+    if (ipc::detail::is_local(h)) {
+        return local_t<Flag>::send(h, data, size, tm, true);
+    }
     return detail_impl<policy_t<Flag>>::send(h, data, size, tm);
 }
 
+template <typename Flag>
+bool chan_impl<Flag>::send(ipc::handle_t h, buff_t && buff, std::uint64_t tm) {
+    if (ipc::detail::is_local(h)) {
+        return local_t<Flag>::send(h, std::move(buff), tm, true);
+    }
+    return detail_impl<policy_t<Flag>>::send(h, buff.data(), buff.size(), tm);
+}
+
+template <typename Flag>
+bool chan_impl<Flag>::send_tagged(ipc::handle_t h, std::uint32_t tag, void const * data, std::size_t size, std::uint64_t tm) {
+    if (ipc::detail::is_local(h)) {
+        return local_t<Flag>::send(h, data, size, tm, true, tag);
+    }
+    return detail_impl<policy_t<Flag>>::send_tagged(h, tag, data, size, tm);
+}
+
+template <typename Flag>
+bool chan_impl<Flag>::relay(ipc::handle_t h, buff_t const & buff, std::uint64_t tm) {
+    if (ipc::detail::is_local(h)) {
+        return local_t<Flag>::send(h, buff.data(), buff.size(), tm, true);
+    }
+    return detail_impl<policy_t<Flag>>::relay(h, buff, tm);
+}
+
+template <typename Flag>
+bool chan_impl<Flag>::send_remote(ipc::handle_t h, void const * data, std::size_t size, std::uint64_t tm) {
+    if (ipc::detail::is_local(h)) {
+        return local_t<Flag>::send(h, data, size, tm, true);
+    }
+    return detail_impl<policy_t<Flag>>::send_remote(h, data, size, tm);
+}
+
+template <typename Flag>
+bool chan_impl<Flag>::send_memfd(ipc::handle_t h, int fd, std::size_t size, std::uint64_t tm) {
+    if (ipc::detail::is_local(h)) {
+        ipc::error("fail: send_memfd, not supported by in-process channels.\n");
+        return false;
+    }
+    return detail_impl<policy_t<Flag>>::send_memfd(h, fd, size, tm);
+}
+
+template <typename Flag>
+bool chan_impl<Flag>::send_memfd(ipc::handle_t h, void const * data, std::size_t size, std::uint64_t tm) {
+    if (ipc::detail::is_local(h)) {
+        return local_t<Flag>::send(h, data, size, tm, true);
+    }
+    return detail_impl<policy_t<Flag>>::send_memfd(h, data, size, tm);
+}
+
+template <typename Flag>
+bool chan_impl<Flag>::publish_all(ipc::handle_t const * hs, std::size_t n, void const * data, std::size_t size, std::uint64_t tm) {
+    if ((hs != nullptr) && std::any_of(hs, hs + n, ipc::detail::is_local)) {
+        // nothing to share between in-process & cross-process channels
+        bool ret = true;
+        for (std::size_t i = 0; i < n; ++i) {
+            ret = send(hs[i], data, size, tm) && ret;
+        }
+        return ret;
+    }
+    return detail_impl<policy_t<Flag>>::publish_all(hs, n, data, size, tm);
+}
+
 template <typename Flag>
 buff_t chan_impl<Flag>::recv(ipc::handle_t h, std::uint64_t tm) {
+    if (ipc::detail::is_local(h)) {
+        return local_t<Flag>::recv(h, tm);
+    }
     return detail_impl<policy_t<Flag>>::recv(h, tm);
 }
 
+template <typename Flag>
+buff_t chan_impl<Flag>::recv_tagged(ipc::handle_t h, std::uint64_t tm, 
+                                    tag_filter_t accept, void const * ctx, std::uint32_t * tag) {
+    if (ipc::detail::is_local(h)) {
+        return local_t<Flag>::recv(h, tm, accept, ctx, tag);
+    }
+    return detail_impl<policy_t<Flag>>::recv(h, tm, accept, ctx, tag);
+}
+
 template <typename Flag>
 bool chan_impl<Flag>::try_send(ipc::handle_t h, void const * data, std::size_t size, std::uint64_t tm) {
+    if (ipc::detail::is_local(h)) {
+        return local_t<Flag>::send(h, data, size, tm, false);
+    }
     return detail_impl<policy_t<Flag>>::try_send(h, data, size, tm);
 }
 
 template <typename Flag>
 buff_t chan_impl<Flag>::try_recv(ipc::handle_t h) {
+    if (ipc::detail::is_local(h)) {
+        return local_t<Flag>::recv(h, 0);
+    }
     return detail_impl<policy_t<Flag>>::try_recv(h);
 }
 
@@ -0,0 +1,269 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <unordered_map>
+#include <condition_variable>
+
+#include "libipc/def.h"
+#include "libipc/ipc.h"
+#include "libipc/pool_alloc.h"
+
+#include "libipc/utility/log.h"
+
+namespace ipc {
+namespace detail {
+
+/// The common head of all channel handles, tells the in-process ones (ipc::local) from the others.
+struct chan_head {
+    bool local_;
+};
+
+inline bool is_local(ipc::handle_t h) noexcept {
+    return (h != nullptr) && static_cast<chan_head *>(h)->local_;
+}
+
+/**
+ * An in-process channel, with the same behaviour as the shm one:
+ * the messages are kept in heap memory, and a sent buffer is handed to the receivers as it is.
+*/
+template <typename Flag>
+class local_chan {
+
+    enum : std::size_t {
+        queue_limit = 256 // as many as a ring holds
+    };
+
+    struct conn_t;
+
+    struct item_t {
+        std::shared_ptr<ipc::buff_t> buf_;
+        conn_t const *               from_;
+        std::uint32_t                tag_;
+    };
+
+    struct conn_t : chan_head {
+        std::shared_ptr<local_chan> chan_;
+        std::string                 name_;
+        bool                        receiving_ = false;
+        bool                        quit_      = false;
+        std::deque<item_t>          que_;      // broadcast only
+
+        conn_t(char const * name)
+            : chan_head{true}
+            , chan_   {local_chan::open(name)}
+            , name_   {name} {
+        }
+    };
+
+    std::mutex              lock_;
+    std::condition_variable rd_cv_, wt_cv_, cc_cv_;
+    std::vector<conn_t *>   receivers_;
+    std::deque<item_t>      que_;              // unicast only
+
+    static std::shared_ptr<local_chan> open(char const * name) {
+        static std::mutex lock;
+        static std::unordered_map<std::string, std::weak_ptr<local_chan>> chans;
+        IPC_UNUSED_ std::lock_guard<std::mutex> guard {lock};
+        auto & wp = chans[name];
+        auto   sp = wp.lock();
+        if (!sp) wp = sp = std::make_shared<local_chan>();
+        return sp;
+    }
+
+    static conn_t * conn_of(ipc::handle_t h) noexcept {
+        return static_cast<conn_t *>(h);
+    }
+
+    std::deque<item_t> & queue_of(conn_t * c) noexcept {
+        return relat_trait<Flag>::is_broadcast ? c->que_ : que_;
+    }
+
+    template <typename F>
+    static bool wait_for(std::condition_variable & cv, std::unique_lock<std::mutex> & lk, std::uint64_t tm, F && pred) {
+        if (tm == ipc::invalid_value) {
+            cv.wait(lk, std::forward<F>(pred));
+            return true;
+        }
+        return cv.wait_for(lk, std::chrono::milliseconds(tm), std::forward<F>(pred));
+    }
+
+    bool full(conn_t const * from) const noexcept {
+        if (!relat_trait<Flag>::is_broadcast) {
+            return que_.size() >= queue_limit;
+        }
+        return std::any_of(receivers_.begin(), receivers_.end(), [from](conn_t const * c) {
+            return (c != from) && (c->que_.size() >= queue_limit);
+        });
+    }
+
+    void drop_oldest() {
+        if (!relat_trait<Flag>::is_broadcast) {
+            if (!que_.empty()) que_.pop_front();
+            return;
+        }
+        for (auto c : receivers_) {
+            if (c->que_.size() >= queue_limit) c->que_.pop_front();
+        }
+    }
+
+    void leave(conn_t * c) {
+        IPC_UNUSED_ std::lock_guard<std::mutex> guard {lock_};
+        c->quit_ = true;
+        if (!c->receiving_) return;
+        c->receiving_ = false;
+        c->que_.clear();
+        receivers_.erase(std::remove(receivers_.begin(), receivers_.end(), c), receivers_.end());
+        rd_cv_.notify_all();
+        wt_cv_.notify_all();
+    }
+
+    /// Gives the buffer out, without copying if this is its last holder.
+    static ipc::buff_t share(std::shared_ptr<ipc::buff_t> && buf) {
+        if (buf.use_count() == 1) {
+            return std::move(*buf);
+        }
+        auto holder = ipc::mem::alloc<std::shared_ptr<ipc::buff_t>>(std::move(buf));
+        return ipc::buff_t{(*holder)->data(), (*holder)->size(), [](void * p, std::size_t) {
+            ipc::mem::free(static_cast<std::shared_ptr<ipc::buff_t> *>(p));
+        }, holder};
+    }
+
+public:
+    static bool reconnect(ipc::handle_t * ph, bool start_to_recv) {
+        auto c = conn_of(*ph);
+        if (c == nullptr) return false;
+        auto chan = c->chan_.get();
+        if (!start_to_recv) {
+            chan->leave(c);
+            return true;
+        }
+        IPC_UNUSED_ std::lock_guard<std::mutex> guard {chan->lock_};
+        c->quit_ = false;
+        if (c->receiving_) return true;
+        c->receiving_ = true;
+        chan->receivers_.push_back(c);
+        chan->cc_cv_.notify_all();
+        return true;
+    }
+
+    static bool connect(ipc::handle_t * ph, char const * name, bool start_to_recv) {
+        if (*ph == nullptr) {
+            *ph = ipc::mem::alloc<conn_t>(name);
+        }
+        return reconnect(ph, start_to_recv);
+    }
+
+    static void disconnect(ipc::handle_t h) {
+        auto c = conn_of(h);
+        if (c == nullptr) return;
+        c->chan_->leave(c);
+    }
+
+    static void destroy(ipc::handle_t h) {
+        disconnect(h);
+        ipc::mem::free(conn_of(h));
+    }
+
+    static char const * name(ipc::handle_t h) {
+        return (conn_of(h) == nullptr) ? nullptr : conn_of(h)->name_.c_str();
+    }
+
+    static std::size_t recv_count(ipc::handle_t h) {
+        auto c = conn_of(h);
+        if (c == nullptr) return ipc::invalid_value;
+        IPC_UNUSED_ std::lock_guard<std::mutex> guard {c->chan_->lock_};
+        return c->chan_->receivers_.size();
+    }
+
+    static bool wait_for_recv(ipc::handle_t h, std::size_t r_count, std::uint64_t tm) {
+        auto c = conn_of(h);
+        if (c == nullptr) return false;
+        auto chan = c->chan_.get();
+        std::unique_lock<std::mutex> lk {chan->lock_};
+        return wait_for(chan->cc_cv_, lk, tm, [chan, r_count] {
+            return chan->receivers_.size() >= r_count;
+        });
+    }
+
+    /**
+     * Sends the buffer to all receivers (one of them for unicast).
+     * If timeout, the oldest messages would be dropped when 'force' is true.
+    */
+    static bool send(ipc::handle_t h, ipc::buff_t && buff, std::uint64_t tm, bool force, std::uint32_t tag = 0) {
+        auto c = conn_of(h);
+        if ((c == nullptr) || buff.empty()) {
+            ipc::error("fail: send, invalid handle or buffer.\n");
+            return false;
+        }
+        auto chan = c->chan_.get();
+        auto buf  = std::make_shared<ipc::buff_t>(std::move(buff));
+        std::unique_lock<std::mutex> lk {chan->lock_};
+        if (chan->receivers_.empty()) {
+            ipc::error("fail: send, there is no receiver on this connection.\n");
+            return false;
+        }
+        if (!wait_for(chan->wt_cv_, lk, tm, [chan, c] { return !chan->full(c); })) {
+            if (!force) return false;
+            ipc::log("force_push: local, size = %zd\n", buf->size());
+            chan->drop_oldest();
+        }
+        if (relat_trait<Flag>::is_broadcast) {
+            for (auto r : chan->receivers_) {
+                if (r != c) r->que_.push_back({buf, c, tag});
+            }
+            chan->rd_cv_.notify_all();
+        } else {
+            chan->que_.push_back({std::move(buf), c, tag});
+            chan->rd_cv_.notify_one();
+        }
+        return true;
+    }
+
+    static bool send(ipc::handle_t h, void const * data, std::size_t size, std::uint64_t tm, bool force, std::uint32_t tag = 0) {
+        if (data == nullptr || size == 0) {
+            ipc::error("fail: send(%p, %zd)\n", data, size);
+            return false;
+        }
+        void * buf = ipc::mem::alloc(size);
+        std::memcpy(buf, data, size);
+        return send(h, ipc::buff_t{buf, size, ipc::mem::free}, tm, force, tag);
+    }
+
+    static ipc::buff_t recv(ipc::handle_t h, std::uint64_t tm, 
+                            tag_filter_t accept = nullptr, void const * ctx = nullptr, std::uint32_t * tag = nullptr) {
+        auto c = conn_of(h);
+        if (c == nullptr) {
+            ipc::error("fail: recv, invalid handle.\n");
+            return {};
+        }
+        auto chan = c->chan_.get();
+        std::unique_lock<std::mutex> lk {chan->lock_};
+        if (!c->receiving_) return {};
+        auto & que = chan->queue_of(c);
+        for (;;) {
+            if (!wait_for(chan->rd_cv_, lk, tm, [c, &que] { return c->quit_ || !que.empty(); }) || c->quit_) {
+                return {};
+            }
+            item_t item = std::move(que.front());
+            que.pop_front();
+            chan->wt_cv_.notify_all();
+            if (item.from_ == c) continue; // ignore message to self
+            if ((accept != nullptr) && !accept(ctx, item.tag_)) continue;
+            if (tag != nullptr) *tag = item.tag_;
+            lk.unlock();
+            return share(std::move(item.buf_));
+        }
+    }
+};
+
+} // namespace detail
+} // namespace ipc
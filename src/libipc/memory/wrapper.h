@@ -4,6 +4,9 @@
 #include <thread>
 #include <deque>        // std::deque
 #include <functional>   // std::function
+#include <memory>       // std::shared_ptr, std::unique_ptr
+#include <vector>
+#include <atomic>
 #include <utility>      // std::forward
 #include <cstddef>
 #include <cassert>      // assert
@@ -121,6 +124,12 @@ public:
     IPC_CONSTEXPR_ void collect(alloc_policy&&)                   noexcept {}
 };
 
+/**
+ * Every thread allocates from a proxy of its own, per wrapper instance
+ * (e.g. the size classes of variable_wrapper are instances of the same type).
+ * A proxy gives its memory back to the recycler when its thread exits,
+ * the recycler is shared by the proxies, so it outlives the wrapper if a proxy does.
+*/
 template <typename AllocP,
           template <typename> class RecyclerP = default_recycler>
 class async_wrapper {
@@ -128,42 +137,59 @@ public:
     using alloc_policy = AllocP;
 
 private:
-    RecyclerP<alloc_policy> recycler_;
+    using recycler_t = RecyclerP<alloc_policy>;
 
     class alloc_proxy : public AllocP {
-        async_wrapper * w_ = nullptr;
+        std::shared_ptr<recycler_t> rc_;
 
     public:
         alloc_proxy(alloc_proxy && rhs) = default;
 
         template <typename ... P>
-        alloc_proxy(async_wrapper* w, P && ... pars)
-            : AllocP(std::forward<P>(pars) ...), w_(w) {
-            assert(w_ != nullptr);
-            w_->recycler_.try_recover(*this);
+        alloc_proxy(std::shared_ptr<recycler_t> rc, P && ... pars)
+            : AllocP(std::forward<P>(pars) ...), rc_(std::move(rc)) {
+            assert(rc_ != nullptr);
+            rc_->try_recover(*this);
         }
 
         ~alloc_proxy() {
-            w_->recycler_.collect(std::move(*this));
+            if (rc_ != nullptr) rc_->collect(std::move(*this));
         }
 
         auto alloc(std::size_t size) {
-            w_->recycler_.try_replenish(*this, size);
+            rc_->try_replenish(*this, size);
             return AllocP::alloc(size);
         }
     };
 
-    friend class alloc_proxy;
     using ref_t = alloc_proxy&;
 
+    /// The proxies of this thread, indexed by the ids of the wrappers.
+    static std::vector<std::unique_ptr<alloc_proxy>> & proxies() {
+        thread_local std::vector<std::unique_ptr<alloc_proxy>> tls;
+        return tls;
+    }
+
+    /// Unlike the address, an id is never reused by a later wrapper.
+    static std::size_t next_id() noexcept {
+        static std::atomic<std::size_t> acc {0};
+        return acc.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::size_t id_ = next_id();
+    std::shared_ptr<recycler_t> recycler_ = std::make_shared<recycler_t>();
     std::function<ref_t()> get_alloc_;
 
 public:
     template <typename ... P>
     async_wrapper(P ... pars) {
         get_alloc_ = [this, pars ...]()->ref_t {
-            thread_local alloc_proxy tls(pars ...);
-            return tls;
+            auto & tls = proxies();
+            if (tls.size() <= id_) tls.resize(id_ + 1);
+            if (tls[id_] == nullptr) {
+                tls[id_].reset(new alloc_proxy(recycler_, pars ...));
+            }
+            return *tls[id_];
         };
     }
 
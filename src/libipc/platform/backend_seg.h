@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+
+#include "libipc/def.h"
+#include "libipc/mutex.h"
+#include "libipc/utility/log.h"
+
+namespace ipc {
+namespace detail {
+
+/**
+ * The shared memory of a mutex or condition: the backend it is opened with, then the object.
+ * The futex and pthread objects of a name open the same segment of the same size,
+ * the first one records its backend, the others fail instead of never waking each other.
+*/
+struct backend_seg {
+    enum : std::size_t { storage_size = 64 };
+
+    std::atomic<std::uint32_t> tag_; // the backend + 1, 0 before anyone took it
+    alignas(std::max_align_t) ipc::byte_t storage_[storage_size];
+
+    template <typename T>
+    T *get() noexcept {
+        static_assert(sizeof(T) <= storage_size, "The object is too big for the segment.");
+        return reinterpret_cast<T *>(storage_);
+    }
+
+    bool take(ipc::sync::backend b, char const *name) noexcept {
+        auto mine = static_cast<std::uint32_t>(b) + 1;
+        std::uint32_t none = 0;
+        if (!tag_.compare_exchange_strong(none, mine, std::memory_order_acq_rel) && (none != mine)) {
+            ipc::error("fail: open(%s) with backend %d, it is opened with backend %d.\n",
+                       name, static_cast<int>(b), static_cast<int>(none - 1));
+            return false;
+        }
+        return true;
+    }
+};
+
+} // namespace detail
+} // namespace ipc
@@ -412,7 +412,9 @@ a0_err_t a0_cnd_wake(a0_cnd_t* cnd, a0_mtx_t* mtx, uint32_t cnt) {
 }
 
 a0_err_t a0_cnd_signal(a0_cnd_t* cnd, a0_mtx_t* mtx) {
-  return a0_cnd_wake(cnd, mtx, 1);
+  // The kernel wakes the top waiter if it could take the mutex, and requeues it otherwise.
+  // Requeuing one more would let a second waiter return from the wait.
+  return a0_cnd_wake(cnd, mtx, 0);
 }
 
 a0_err_t a0_cnd_broadcast(a0_cnd_t* cnd, a0_mtx_t* mtx) {
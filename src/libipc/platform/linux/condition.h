@@ -50,6 +50,10 @@ public:
         return true;
     }
 
+    /**
+     * Wakes one waiter, and requeues the others onto the futex of 'mtx' (see: a0_cnd_wake, FUTEX_CMP_REQUEUE_PI).
+     * They are handed the mutex one by one as it is unlocked, instead of all waking up to fight for it.
+    */
     bool broadcast(ipc::sync::mutex &mtx) noexcept {
         if (!valid()) return false;
         int eno = A0_SYSERR(a0_cnd_broadcast(native(), static_cast<a0_mtx_t *>(mtx.native())));
@@ -20,6 +20,10 @@ namespace ipc {
 namespace detail {
 namespace sync {
 
+/**
+ * a0_mtx_t is robust & priority-inheriting: a contended lock is handed to the kernel
+ * through FUTEX_LOCK_PI, so a blocked high-priority waiter boosts the current owner.
+*/
 class robust_mutex : public sync::obj_impl<a0_mtx_t> {
 public:
     bool lock(std::uint64_t tm) noexcept {
@@ -128,6 +132,13 @@ class mutex {
             it = info.mutex_handles.emplace(name, 
                   curr_prog::shm_data::init{name}).first;
         }
+        if (!it->second.mtx.valid()) {
+            // opened with the other backend, don't keep it
+            if (it->second.ref.load(std::memory_order_relaxed) == 0) {
+                info.mutex_handles.erase(it);
+            }
+            return;
+        }
         mutex_ = &it->second.mtx;
         ref_   = &it->second.ref;
     }
@@ -167,7 +178,8 @@ public:
         return (mutex_ != nullptr) && (ref_ != nullptr) && mutex_->valid();
     }
 
-    bool open(char const *name) noexcept {
+    /// a0_mtx_t is always priority-inheriting, whatever 'prio_inherit' is.
+    bool open(char const *name, bool /*prio_inherit*/) noexcept {
         close();
         acquire_mutex(name);
         if (!valid()) {
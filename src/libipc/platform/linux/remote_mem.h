@@ -0,0 +1,175 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cerrno>
+
+#include <cstdio>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "libipc/utility/log.h"
+
+namespace ipc {
+namespace detail {
+
+inline std::int32_t current_pid() noexcept {
+    return static_cast<std::int32_t>(::getpid());
+}
+
+/**
+ * Copies 'size' bytes at 'addr' in process 'pid' into 'dst' (see: process_vm_readv).
+ * The caller needs the permission of ptrace-attaching to 'pid':
+ * the same uid, and with yama, ptrace_scope == 0 or PR_SET_PTRACER set by the peer.
+*/
+inline bool read_remote_mem(std::int32_t pid, std::uint64_t addr, void *dst, std::size_t size) noexcept {
+    auto *out = static_cast<char *>(dst);
+    while (size > 0) {
+        iovec local  {out, size};
+        iovec remote {reinterpret_cast<void *>(static_cast<std::uintptr_t>(addr)), size};
+        ssize_t n = ::process_vm_readv(static_cast<pid_t>(pid), &local, 1, &remote, 1, 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EPERM) {
+                ipc::error("fail process_vm_readv[EPERM]: no permission to read process %d, "
+                           "check /proc/sys/kernel/yama/ptrace_scope or PR_SET_PTRACER.\n", (int)pid);
+            } else {
+                ipc::error("fail process_vm_readv[%d]: pid = %d, size = %zd\n", errno, (int)pid, size);
+            }
+            return false;
+        }
+        if (n == 0) {
+            ipc::error("fail process_vm_readv: nothing has been read, pid = %d\n", (int)pid);
+            return false;
+        }
+        // partial read, continue with the rest
+        out  += n;
+        addr += static_cast<std::uint64_t>(n);
+        size -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+inline void close_fd(int fd) noexcept {
+    ::close(fd);
+}
+
+/**
+ * Creates a memfd holding a copy of 'data', sealed against any later change,
+ * so receivers could map it without trusting the sender. Returns -1 on failure.
+*/
+inline int make_sealed_memfd(void const *data, std::size_t size) noexcept {
+    int fd = static_cast<int>(::syscall(SYS_memfd_create, "ipc-memfd", MFD_CLOEXEC | MFD_ALLOW_SEALING));
+    if (fd < 0) {
+        ipc::error("fail memfd_create[%d]: size = %zd\n", errno, size);
+        return -1;
+    }
+    if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        ipc::error("fail ftruncate[%d]: memfd size = %zd\n", errno, size);
+        ::close(fd);
+        return -1;
+    }
+    // write(2) instead of a mapping: F_SEAL_WRITE is refused while a writable mapping exists
+    auto const *src = static_cast<char const *>(data);
+    for (std::size_t off = 0; off < size;) {
+        ssize_t n = ::pwrite(fd, src + off, size - off, static_cast<off_t>(off));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            ipc::error("fail pwrite[%d]: memfd size = %zd\n", errno, size);
+            ::close(fd);
+            return -1;
+        }
+        off += static_cast<std::size_t>(n);
+    }
+    if (::fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) != 0) {
+        ipc::error("fail fcntl[%d]: F_ADD_SEALS\n", errno);
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * Checks that 'fd' is a memfd of at least 'size' bytes,
+ * which can neither shrink, grow nor be written any more.
+*/
+inline bool check_sealed_memfd(int fd, std::size_t size) noexcept {
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ipc::error("fail fstat[%d]: fd = %d\n", errno, fd);
+        return false;
+    }
+    if ((st.st_size < 0) || (static_cast<std::uint64_t>(st.st_size) < size)) {
+        ipc::error("fail: memfd is smaller than the message, fd = %d, %lld < %zd\n", 
+                   fd, (long long)st.st_size, size);
+        return false;
+    }
+    int seals = ::fcntl(fd, F_GET_SEALS);
+    if (seals < 0) {
+        ipc::error("fail fcntl[%d]: F_GET_SEALS, fd = %d is not a memfd?\n", errno, fd);
+        return false;
+    }
+    constexpr int required = F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE;
+    if ((seals & required) != required) {
+        ipc::error("fail: memfd is not sealed, fd = %d, seals = %#x\n", fd, seals);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Duplicates the descriptor 'fd' of process 'pid' into this process.
+ * Uses pidfd_getfd (Linux 5.6), which needs the permission of ptrace-attaching to 'pid',
+ * so with yama ptrace_scope >= 1 it fails by EPERM (see: read_remote_mem).
+ * Then, or without pidfd_getfd, falls back to opening /proc/<pid>/fd/<fd>,
+ * which only needs the permission of reading /proc/<pid> (the same uid), not yama's.
+*/
+inline int dup_remote_fd(std::int32_t pid, int fd) noexcept {
+#if defined(SYS_pidfd_open) && defined(SYS_pidfd_getfd)
+    int pfd = static_cast<int>(::syscall(SYS_pidfd_open, static_cast<pid_t>(pid), 0));
+    if (pfd >= 0) {
+        int ret = static_cast<int>(::syscall(SYS_pidfd_getfd, pfd, fd, 0));
+        int eno = errno;
+        ::close(pfd);
+        if (ret >= 0) {
+            ::fcntl(ret, F_SETFD, FD_CLOEXEC);
+            return ret;
+        }
+        if ((eno != EPERM) && (eno != ENOSYS)) {
+            ipc::error("fail pidfd_getfd[%d]: pid = %d, fd = %d\n", eno, (int)pid, fd);
+            return -1;
+        }
+        // EPERM: restricted by yama, try the /proc way below
+    }
+#endif
+    char path[64];
+    std::snprintf(path, sizeof(path), "/proc/%d/fd/%d", (int)pid, fd);
+    int ret = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (ret < 0) {
+        ipc::error("fail dup_remote_fd[%d]: pid = %d, fd = %d\n", errno, (int)pid, fd);
+    }
+    return ret;
+}
+
+/// Maps a memfd read-only. Returns nullptr on failure.
+inline void *map_memfd(int fd, std::size_t size) noexcept {
+    void *mem = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (mem == MAP_FAILED) {
+        ipc::error("fail mmap[%d]: memfd size = %zd\n", errno, size);
+        return nullptr;
+    }
+    return mem;
+}
+
+inline void unmap_memfd(void *mem, std::size_t size) noexcept {
+    ::munmap(mem, size);
+}
+
+} // namespace detail
+} // namespace ipc
@@ -2,6 +2,7 @@
 
 #include "libipc/utility/log.h"
 #include "libipc/shm.h"
+#include "libipc/platform/backend_seg.h"
 
 #include "a0/empty.h"
 
@@ -19,11 +20,16 @@ protected:
     sync_t *h_ = nullptr;
 
     sync_t *acquire_handle(char const *name) {
-        if (!shm_.acquire(name, sizeof(sync_t))) {
+        if (!shm_.acquire(name, sizeof(detail::backend_seg))) {
             ipc::error("[acquire_handle] fail shm.acquire: %s\n", name);
             return nullptr;
         }
-        return static_cast<sync_t *>(shm_.get());
+        auto seg = static_cast<detail::backend_seg *>(shm_.get());
+        if (!seg->take(ipc::sync::backend::futex, name)) {
+            shm_.release();
+            return nullptr;
+        }
+        return seg->get<sync_t>();
     }
 
 public:
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <climits>
+#include <cerrno>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace ipc {
+namespace detail {
+namespace sync {
+
+static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t),
+              "A futex word should be a plain 32-bit integer.");
+
+/**
+ * Sleeps while 'word' is 'val', for 'tm' ms at most (a shared futex, it works across processes).
+*/
+inline void wait_word(std::atomic<std::uint32_t> &word, std::uint32_t val, std::uint64_t tm) noexcept {
+    timespec ts {static_cast<time_t>(tm / 1000), static_cast<long>((tm % 1000) * 1000000)};
+    ::syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&word), FUTEX_WAIT, val, &ts, nullptr, 0);
+}
+
+inline void wake_word(std::atomic<std::uint32_t> &word) noexcept {
+    ::syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+inline std::uint32_t this_process() noexcept {
+    return static_cast<std::uint32_t>(::getpid());
+}
+
+inline bool process_alive(std::uint32_t pid) noexcept {
+    return (::kill(static_cast<pid_t>(pid), 0) == 0) || (errno != ESRCH);
+}
+
+} // namespace sync
+} // namespace detail
+} // namespace ipc
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <utility>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#   include <cpuid.h>
+#   include <immintrin.h>
+#   include <x86intrin.h>
+#   define IPC_WAITPKG_
+#endif
+
+namespace ipc {
+namespace detail {
+
+/**
+ * Whether the cpu has the user-level monitor/mwait (WAITPKG: umonitor, umwait, tpause),
+ * checked once by cpuid at run time.
+*/
+inline bool has_waitpkg() noexcept {
+#if defined(IPC_WAITPKG_)
+    static bool const ret = [] {
+        unsigned a = 0, b = 0, c = 0, d = 0;
+        if (__get_cpuid_max(0, nullptr) < 7) return false;
+        __cpuid_count(7, 0, a, b, c, d);
+        return (c & (1u << 5)) != 0;
+    }();
+    return ret;
+#else
+    return false;
+#endif
+}
+
+#if defined(IPC_WAITPKG_)
+__attribute__((target("waitpkg")))
+inline void umonitor(void const * addr) noexcept {
+    _umonitor(const_cast<void *>(addr));
+}
+
+/**
+ * Sleeps in C0.1 (the lighter one, for a quick wake up) until the monitored line is written,
+ * or about 'cycles' tsc ticks have passed. The OS might cut it shorter (see: IA32_UMWAIT_CONTROL).
+*/
+__attribute__((target("waitpkg")))
+inline void umwait(std::uint64_t cycles) noexcept {
+    _umwait(1, __rdtsc() + cycles);
+}
+#endif
+
+inline void cpu_relax() noexcept {
+#if defined(IPC_WAITPKG_)
+    _mm_pause();
+#else
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+/**
+ * Runs 'pred' once, and if it fails, waits a little for 'addr' to be written:
+ * parked by umonitor/umwait on the cache line of 'addr' if the cpu could, or just a pause.
+ * The line is armed before 'pred', so a write in between won't be missed.
+*/
+template <typename F>
+bool monitor_wait(void const * addr, F && pred) {
+#if defined(IPC_WAITPKG_)
+    if ((addr != nullptr) && has_waitpkg()) {
+        umonitor(addr);
+        if (std::forward<F>(pred)()) return true;
+        umwait(100000);
+        return false;
+    }
+#endif
+    if (std::forward<F>(pred)()) return true;
+    cpu_relax();
+    return false;
+}
+
+} // namespace detail
+} // namespace ipc
+
+#undef IPC_WAITPKG_
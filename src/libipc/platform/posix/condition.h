@@ -9,23 +9,29 @@
 #include "libipc/utility/scope_guard.h"
 #include "libipc/mutex.h"
 #include "libipc/shm.h"
+#include "libipc/platform/backend_seg.h"
 
 #include "get_wait_time.h"
 
 namespace ipc {
 namespace detail {
-namespace sync {
+namespace posix {
 
 class condition {
     ipc::shm::handle shm_;
     pthread_cond_t *cond_ = nullptr;
 
     pthread_cond_t *acquire_cond(char const *name) {
-        if (!shm_.acquire(name, sizeof(pthread_cond_t))) {
+        if (!shm_.acquire(name, sizeof(detail::backend_seg))) {
             ipc::error("[acquire_cond] fail shm.acquire: %s\n", name);
             return nullptr;
         }
-        return static_cast<pthread_cond_t *>(shm_.get());
+        auto seg = static_cast<detail::backend_seg *>(shm_.get());
+        if (!seg->take(ipc::sync::backend::pthread, name)) {
+            shm_.release();
+            return nullptr;
+        }
+        return seg->get<pthread_cond_t>();
     }
 
 public:
@@ -100,7 +106,7 @@ public:
             }
             break;
         default: {
-                auto ts = detail::make_timespec(tm);
+                auto ts = posix::make_timespec(tm);
                 int eno;
                 if ((eno = ::pthread_cond_timedwait(cond_, static_cast<pthread_mutex_t *>(mtx.native()), &ts)) != 0) {
                     if (eno != ETIMEDOUT) {
@@ -136,6 +142,6 @@ public:
     }
 };
 
-} // namespace sync
+} // namespace posix
 } // namespace detail
 } // namespace ipc
@@ -11,6 +11,7 @@
 
 namespace ipc {
 namespace detail {
+namespace posix {
 
 inline bool calc_wait_time(timespec &ts, std::uint64_t tm /*ms*/) noexcept {
     timeval now;
@@ -35,5 +36,6 @@ inline timespec make_timespec(std::uint64_t tm /*ms*/) noexcept(false) {
     return ts;
 }
 
+} // namespace posix
 } // namespace detail
 } // namespace ipc
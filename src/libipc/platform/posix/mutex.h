@@ -14,12 +14,13 @@
 #include "libipc/utility/scope_guard.h"
 #include "libipc/memory/resource.h"
 #include "libipc/shm.h"
+#include "libipc/platform/backend_seg.h"
 
 #include "get_wait_time.h"
 
 namespace ipc {
 namespace detail {
-namespace sync {
+namespace posix {
 
 class mutex {
     ipc::shm::handle *shm_ = nullptr;
@@ -56,14 +57,18 @@ class mutex {
         auto it = info.mutex_handles.find(name);
         if (it == info.mutex_handles.end()) {
             it = info.mutex_handles.emplace(name, 
-                  curr_prog::shm_data::init{name, sizeof(pthread_mutex_t)}).first;
+                  curr_prog::shm_data::init{name, sizeof(detail::backend_seg)}).first;
         }
-        shm_ = &it->second.shm;
-        ref_ = &it->second.ref;
-        if (shm_ == nullptr) {
+        auto seg = static_cast<detail::backend_seg *>(it->second.shm.get());
+        if ((seg == nullptr) || !seg->take(ipc::sync::backend::pthread, name)) {
+            if (it->second.ref.load(std::memory_order_relaxed) == 0) {
+                info.mutex_handles.erase(it);
+            }
             return nullptr;
         }
-        return static_cast<pthread_mutex_t *>(shm_->get());
+        shm_ = &it->second.shm;
+        ref_ = &it->second.ref;
+        return seg->get<pthread_mutex_t>();
     }
 
     template <typename F>
@@ -108,7 +113,7 @@ public:
             && (std::memcmp(&zero_mem(), mutex_, sizeof(pthread_mutex_t)) != 0);
     }
 
-    bool open(char const *name) noexcept {
+    bool open(char const *name, bool prio_inherit) noexcept {
         close();
         if ((mutex_ = acquire_mutex(name)) == nullptr) {
             return false;
@@ -135,6 +140,11 @@ public:
             ipc::error("fail pthread_mutexattr_setrobust[%d]\n", eno);
             return false;
         }
+        // Opt-in: the same semantics as the a0 mutex on Linux (see: a0/mtx.h).
+        if (prio_inherit && (eno = ::pthread_mutexattr_setprotocol(&mutex_attr, PTHREAD_PRIO_INHERIT)) != 0) {
+            ipc::error("fail pthread_mutexattr_setprotocol[%d]\n", eno);
+            return false;
+        }
         *mutex_ = PTHREAD_MUTEX_INITIALIZER;
         if ((eno = ::pthread_mutex_init(mutex_, &mutex_attr)) != 0) {
             ipc::error("fail pthread_mutex_init[%d]\n", eno);
@@ -168,7 +178,7 @@ public:
     bool lock(std::uint64_t tm) noexcept {
         if (!valid()) return false;
         for (;;) {
-            auto ts = detail::make_timespec(tm);
+            auto ts = posix::make_timespec(tm);
             int eno = (tm == invalid_value) 
                 ? ::pthread_mutex_lock(mutex_) 
                 : ::pthread_mutex_timedlock(mutex_, &ts);
@@ -202,7 +212,7 @@ public:
 
     bool try_lock() noexcept(false) {
         if (!valid()) return false;
-        auto ts = detail::make_timespec(0);
+        auto ts = posix::make_timespec(0);
         int eno = ::pthread_mutex_timedlock(mutex_, &ts);
         switch (eno) {
         case 0:
@@ -243,6 +253,6 @@ public:
     }
 };
 
-} // namespace sync
+} // namespace posix
 } // namespace detail
 } // namespace ipc
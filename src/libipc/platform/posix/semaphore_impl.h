@@ -70,7 +70,7 @@ public:
                 return false;
             }
         } else {
-            auto ts = detail::make_timespec(tm);
+            auto ts = posix::make_timespec(tm);
             if (::sem_timedwait(h_, &ts) != 0) {
                 if (errno != ETIMEDOUT) {
                     ipc::error("fail sem_timedwait[%d]: tm = %zd, tv_sec = %ld, tv_nsec = %ld\n",
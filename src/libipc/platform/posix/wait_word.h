@@ -0,0 +1,39 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <chrono>
+#include <thread>
+#include <cerrno>
+
+#include <sys/types.h>
+#include <signal.h>
+#include <unistd.h>
+
+namespace ipc {
+namespace detail {
+namespace sync {
+
+/**
+ * No futex here: just polls 'word' every millisecond, for 'tm' ms at most.
+*/
+inline void wait_word(std::atomic<std::uint32_t> &word, std::uint32_t val, std::uint64_t tm) noexcept {
+    for (std::uint64_t k = 0; (k < tm) && (word.load(std::memory_order_acquire) == val); ++k) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+inline void wake_word(std::atomic<std::uint32_t> &) noexcept {
+}
+
+inline std::uint32_t this_process() noexcept {
+    return static_cast<std::uint32_t>(::getpid());
+}
+
+inline bool process_alive(std::uint32_t pid) noexcept {
+    return (::kill(static_cast<pid_t>(pid), 0) == 0) || (errno != ESRCH);
+}
+
+} // namespace sync
+} // namespace detail
+} // namespace ipc
@@ -31,7 +31,7 @@ public:
         return h_ != NULL;
     }
 
-    bool open(char const *name) noexcept {
+    bool open(char const *name, bool /*prio_inherit*/) noexcept {
         close();
         h_ = ::CreateMutex(detail::get_sa(), FALSE, ipc::detail::to_tchar(name).c_str());
         if (h_ == NULL) {
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <chrono>
+#include <thread>
+
+#include <Windows.h>
+
+namespace ipc {
+namespace detail {
+namespace sync {
+
+/**
+ * WaitOnAddress doesn't work across processes: just polls 'word' every millisecond, for 'tm' ms at most.
+*/
+inline void wait_word(std::atomic<std::uint32_t> &word, std::uint32_t val, std::uint64_t tm) noexcept {
+    for (std::uint64_t k = 0; (k < tm) && (word.load(std::memory_order_acquire) == val); ++k) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+inline void wake_word(std::atomic<std::uint32_t> &) noexcept {
+}
+
+inline std::uint32_t this_process() noexcept {
+    return static_cast<std::uint32_t>(::GetCurrentProcessId());
+}
+
+inline bool process_alive(std::uint32_t pid) noexcept {
+    HANDLE h = ::OpenProcess(SYNCHRONIZE, FALSE, static_cast<DWORD>(pid));
+    if (h == NULL) return ::GetLastError() == ERROR_ACCESS_DENIED;
+    bool alive = (::WaitForSingleObject(h, 0) == WAIT_TIMEOUT);
+    ::CloseHandle(h);
+    return alive;
+}
+
+} // namespace sync
+} // namespace detail
+} // namespace ipc
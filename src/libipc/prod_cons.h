@@ -26,7 +26,7 @@ template <>
 struct prod_cons_impl<wr<relat::single, relat::single, trans::unicast>> {
 
     template <std::size_t DataSize, std::size_t AlignSize>
-    struct elem_t {
+    struct alignas(cache_line_size) elem_t {
         std::aligned_storage_t<DataSize, AlignSize> data_ {};
     };
 
@@ -37,6 +37,12 @@ struct prod_cons_impl<wr<relat::single, relat::single, trans::unicast>> {
         return 0;
     }
 
+    /// The word a sender writes last for the next message, unicast receivers are waiting on it.
+    template <typename E>
+    void const * commit_addr(circ::u2_t /*cur*/, E const * /*elems*/) const noexcept {
+        return &wt_;
+    }
+
     template <typename W, typename F, typename E>
     bool push(W* /*wrapper*/, F&& f, E* elems) {
         auto cur_wt = circ::index_of(wt_.load(std::memory_order_relaxed));
@@ -109,7 +115,7 @@ struct prod_cons_impl<wr<relat::multi , relat::multi, trans::unicast>>
     using flag_t = std::uint64_t;
 
     template <std::size_t DataSize, std::size_t AlignSize>
-    struct elem_t {
+    struct alignas(cache_line_size) elem_t {
         std::aligned_storage_t<DataSize, AlignSize> data_ {};
         std::atomic<flag_t> f_ct_ { 0 }; // commit flag
     };
@@ -203,7 +209,7 @@ struct prod_cons_impl<wr<relat::single, relat::multi, trans::broadcast>> {
     };
 
     template <std::size_t DataSize, std::size_t AlignSize>
-    struct elem_t {
+    struct alignas(cache_line_size) elem_t {
         std::aligned_storage_t<DataSize, AlignSize> data_ {};
         std::atomic<rc_t> rc_ { 0 }; // read-counter
     };
@@ -215,6 +221,11 @@ struct prod_cons_impl<wr<relat::single, relat::multi, trans::broadcast>> {
         return wt_.load(std::memory_order_acquire);
     }
 
+    template <typename E>
+    void const * commit_addr(circ::u2_t /*cur*/, E const * /*elems*/) const noexcept {
+        return &wt_;
+    }
+
     template <typename W, typename F, typename E>
     bool push(W* wrapper, F&& f, E* elems) {
         E* el;
@@ -304,7 +315,7 @@ struct prod_cons_impl<wr<relat::multi, relat::multi, trans::broadcast>> {
     };
 
     template <std::size_t DataSize, std::size_t AlignSize>
-    struct elem_t {
+    struct alignas(cache_line_size) elem_t {
         std::aligned_storage_t<DataSize, AlignSize> data_ {};
         std::atomic<rc_t  > rc_   { 0 }; // read-counter
         std::atomic<flag_t> f_ct_ { 0 }; // commit flag
@@ -317,6 +328,12 @@ struct prod_cons_impl<wr<relat::multi, relat::multi, trans::broadcast>> {
         return ct_.load(std::memory_order_acquire);
     }
 
+    /// ct_ moves on before the data is written, a message is committed by the flag of its slot.
+    template <typename E>
+    void const * commit_addr(circ::u2_t cur, E const * elems) const noexcept {
+        return &(elems[circ::index_of(cur)].f_ct_);
+    }
+
     constexpr static rc_t inc_rc(rc_t rc) noexcept {
         return (rc & ic_mask) | ((rc + ic_incr) & ~ic_mask);
     }
@@ -155,6 +155,10 @@ public:
         return !valid() || (cursor_ == elems_->cursor());
     }
 
+    void const * commit_addr() const noexcept {
+        return (elems_ == nullptr) ? nullptr : elems_->commit_addr(cursor_);
+    }
+
     template <typename T, typename F, typename... P>
     bool push(F&& prep, P&&... params) {
         if (elems_ == nullptr) return false;
@@ -0,0 +1,107 @@
+
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+#include "libipc/mutex.h"
+#include "libipc/utility/log.h"
+#include "libipc/platform/detail.h"
+#include "libipc/sync/backend.h"
+
+namespace {
+
+constexpr bool supported(ipc::sync::backend b) noexcept {
+#if defined(IPC_OS_WINDOWS_)
+    return b == ipc::sync::backend::win32;
+#elif defined(IPC_OS_LINUX_)
+    return b != ipc::sync::backend::win32;
+#else
+    return b == ipc::sync::backend::pthread;
+#endif
+}
+
+ipc::sync::backend default_backend() noexcept {
+#if defined(IPC_OS_WINDOWS_)
+    return ipc::sync::backend::win32;
+#elif defined(IPC_OS_LINUX_)
+# if defined(LIBIPC_SYNC_PTHREAD__)
+    ipc::sync::backend b = ipc::sync::backend::pthread;
+# else
+    ipc::sync::backend b = ipc::sync::backend::futex;
+# endif
+    char const *env = std::getenv("LIBIPC_SYNC_BACKEND");
+    if ((env == nullptr) || (env[0] == '\0')) {
+        return b;
+    }
+    if (std::strcmp(env, "futex") == 0) {
+        return ipc::sync::backend::futex;
+    }
+    if (std::strcmp(env, "pthread") == 0) {
+        return ipc::sync::backend::pthread;
+    }
+    ipc::error("fail: LIBIPC_SYNC_BACKEND = %s, expected futex or pthread.\n", env);
+    return b;
+#else
+    return ipc::sync::backend::pthread;
+#endif
+}
+
+struct backend_state {
+    std::mutex         lock;
+    ipc::sync::backend which  = default_backend();
+    long               opened = 0;
+
+    static backend_state &get() {
+        static backend_state state;
+        return state;
+    }
+};
+
+} // internal-linkage
+
+namespace ipc {
+namespace detail {
+namespace sync {
+
+ipc::sync::backend enter_backend() noexcept {
+    auto &st = backend_state::get();
+    IPC_UNUSED_ std::lock_guard<std::mutex> guard {st.lock};
+    ++st.opened;
+    return st.which;
+}
+
+void leave_backend() noexcept {
+    auto &st = backend_state::get();
+    IPC_UNUSED_ std::lock_guard<std::mutex> guard {st.lock};
+    --st.opened;
+}
+
+} // namespace sync
+} // namespace detail
+
+namespace sync {
+
+backend current_backend() noexcept {
+    auto &st = backend_state::get();
+    IPC_UNUSED_ std::lock_guard<std::mutex> guard {st.lock};
+    return st.which;
+}
+
+bool use_backend(backend b) noexcept {
+    if (!supported(b)) {
+        ipc::error("fail: use_backend(%d), not supported here.\n", static_cast<int>(b));
+        return false;
+    }
+    auto &st = backend_state::get();
+    IPC_UNUSED_ std::lock_guard<std::mutex> guard {st.lock};
+    if (st.which == b) return true;
+    if (st.opened > 0) {
+        ipc::error("fail: use_backend(%d), %ld objects are still opened.\n", static_cast<int>(b), st.opened);
+        return false;
+    }
+    st.which = b;
+    return true;
+}
+
+} // namespace sync
+} // namespace ipc
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <utility>
+
+#include "libipc/mutex.h"
+#include "libipc/utility/log.h"
+
+namespace ipc {
+namespace detail {
+namespace sync {
+
+/// Takes the current backend for an object being opened, which keeps it from being switched.
+ipc::sync::backend enter_backend() noexcept;
+void leave_backend() noexcept;
+
+template <typename... T>
+class backend_obj;
+
+/**
+ * The only implementation on this platform.
+*/
+template <typename T>
+class backend_obj<T> {
+    T obj_;
+
+public:
+    template <typename F>
+    decltype(auto) visit(F &&f) {
+        return std::forward<F>(f)(obj_);
+    }
+
+    template <typename F>
+    decltype(auto) visit(F &&f) const {
+        return std::forward<F>(f)(obj_);
+    }
+
+    template <typename... A>
+    bool open(char const *name, A... args) noexcept {
+        return obj_.open(name, args...);
+    }
+
+    void close() noexcept {
+        obj_.close();
+    }
+};
+
+/**
+ * Both of the implementations on Linux, the one in use is chosen when opening.
+ * Both open the segment of the same name, which records the backend of the first one opening it
+ * (see: backend_seg), the processes opening it with the other one fail, instead of never waking each other.
+*/
+template <typename Futex, typename Pthread>
+class backend_obj<Futex, Pthread> {
+    Futex   futex_;
+    Pthread pthread_;
+    ipc::sync::backend which_ = ipc::sync::backend::futex;
+    bool entered_ = false;
+
+public:
+    template <typename F>
+    decltype(auto) visit(F &&f) {
+        return (which_ == ipc::sync::backend::pthread) ? std::forward<F>(f)(pthread_)
+                                                        : std::forward<F>(f)(futex_);
+    }
+
+    template <typename F>
+    decltype(auto) visit(F &&f) const {
+        return (which_ == ipc::sync::backend::pthread) ? std::forward<F>(f)(pthread_)
+                                                        : std::forward<F>(f)(futex_);
+    }
+
+    template <typename... A>
+    bool open(char const *name, A... args) noexcept {
+        close();
+        if ((name == nullptr) || (name[0] == '\0')) {
+            ipc::error("fail: backend_obj::open, the name is empty.\n");
+            return false;
+        }
+        which_   = enter_backend();
+        entered_ = true;
+        bool ok = (which_ == ipc::sync::backend::pthread)
+                ? pthread_.open(name, args...)
+                : futex_.open(name, args...);
+        if (!ok) close();
+        return ok;
+    }
+
+    void close() noexcept {
+        visit([](auto &obj) { obj.close(); });
+        if (entered_) {
+            entered_ = false;
+            leave_backend();
+        }
+    }
+};
+
+} // namespace sync
+} // namespace detail
+} // namespace ipc
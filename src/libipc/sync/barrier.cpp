@@ -0,0 +1,185 @@
+
+#include <atomic>
+
+#include "libipc/barrier.h"
+#include "libipc/shm.h"
+
+#include "libipc/utility/pimpl.h"
+#include "libipc/utility/log.h"
+#include "libipc/memory/resource.h"
+#include "libipc/sync/participants.h"
+
+namespace {
+
+enum : std::uint32_t {
+    broken_flag    = 0x80000000u,
+    phase_mask     = ~broken_flag,
+    resetting_flag = 0x80000000u  // of expected_
+};
+
+struct barrier_t {
+    std::atomic<std::uint32_t> seq_;      // the phase, waited on; broken_flag once broken
+    std::atomic<std::uint32_t> arrived_;
+    std::atomic<std::uint32_t> expected_; // 0 until the first one opens it
+    ipc::detail::sync::participants members_;
+
+    std::uint32_t wait_reset() const noexcept {
+        auto curr = expected_.load(std::memory_order_acquire);
+        for (unsigned k = 0; curr & resetting_flag; curr = expected_.load(std::memory_order_acquire)) {
+            ipc::yield(k);
+        }
+        return curr;
+    }
+
+    /**
+     * Starts over if nobody alive has it open, and it is broken or in the middle of a phase:
+     * the next one opening it with a count inits it again.
+    */
+    void renew() noexcept {
+        auto curr = wait_reset();
+        if ((curr == 0) || members_.any_alive()) return;
+        if (((seq_.load(std::memory_order_acquire) & broken_flag) == 0) &&
+            (arrived_.load(std::memory_order_acquire) == 0)) return;
+        if (!expected_.compare_exchange_strong(curr, resetting_flag, std::memory_order_acq_rel)) {
+            wait_reset(); // somebody else is at it
+            return;
+        }
+        members_.reset();
+        arrived_.store(0, std::memory_order_relaxed);
+        seq_    .store(0, std::memory_order_relaxed);
+        expected_.store(0, std::memory_order_release);
+    }
+};
+
+} // internal-linkage
+
+namespace ipc {
+namespace sync {
+
+class barrier::barrier_ : public ipc::pimpl<barrier_> {
+public:
+    ipc::shm::handle shm_;
+    barrier_t *      h_    = nullptr;
+    std::uint32_t    slot_ = ipc::detail::sync::participants::max_count;
+
+    void break_it() noexcept {
+        h_->seq_.fetch_or(broken_flag, std::memory_order_acq_rel);
+        ipc::detail::sync::wake_word(h_->seq_);
+    }
+};
+
+barrier::barrier()
+    : p_(p_->make()) {
+}
+
+barrier::barrier(char const *name, std::uint32_t count)
+    : barrier() {
+    open(name, count);
+}
+
+barrier::~barrier() {
+    close();
+    p_->clear();
+}
+
+void const *barrier::native() const noexcept {
+    return impl(p_)->h_;
+}
+
+void *barrier::native() noexcept {
+    return impl(p_)->h_;
+}
+
+bool barrier::valid() const noexcept {
+    return impl(p_)->h_ != nullptr;
+}
+
+bool barrier::open(char const *name, std::uint32_t count) noexcept {
+    close();
+    auto p = impl(p_);
+    if ((name == nullptr) || (name[0] == '\0') || (count > ipc::detail::sync::participants::max_count)) {
+        ipc::error("fail: barrier::open(%s, %u)\n", name, count);
+        return false;
+    }
+    if (!p->shm_.acquire((ipc::string{"__BARRIER__"} + name).c_str(), sizeof(barrier_t))) {
+        ipc::error("[barrier::open] fail shm.acquire: %s\n", name);
+        return false;
+    }
+    auto h = static_cast<barrier_t *>(p->shm_.get());
+    // left behind by processes which are all gone
+    h->renew();
+    std::uint32_t expected = 0;
+    if (!h->expected_.compare_exchange_strong(expected, count, std::memory_order_acq_rel) &&
+        (count != 0) && (expected != count)) {
+        ipc::error("fail: barrier::open(%s, %u), the count is %u\n", name, count, expected);
+        p->shm_.release();
+        return false;
+    }
+    // taking the seat of a dead one: if it had not arrived yet, the current phase is broken,
+    // otherwise its arrival is kept
+    if ((p->slot_ = h->members_.join(0, [h](std::uint32_t done) {
+            auto seq = h->seq_.load(std::memory_order_acquire);
+            if (done != ((seq + 1) & phase_mask)) {
+                h->seq_.fetch_or(broken_flag, std::memory_order_acq_rel);
+                ipc::detail::sync::wake_word(h->seq_);
+            }
+            return done;
+        })) >= ipc::detail::sync::participants::max_count) {
+        ipc::error("fail: barrier::open(%s), too many participants.\n", name);
+        p->shm_.release();
+        return false;
+    }
+    p->h_ = h;
+    return true;
+}
+
+void barrier::close() noexcept {
+    auto p = impl(p_);
+    if (p->h_ == nullptr) return;
+    p->h_->members_.leave(p->slot_);
+    p->slot_ = ipc::detail::sync::participants::max_count;
+    p->h_ = nullptr;
+    p->shm_.release();
+}
+
+bool barrier::arrive_and_wait(std::uint64_t tm) noexcept {
+    auto p = impl(p_);
+    if (!valid()) return false;
+    auto h = p->h_;
+    auto expected = h->expected_.load(std::memory_order_acquire);
+    if (expected == 0) {
+        ipc::error("fail: barrier::arrive_and_wait, the count is unknown.\n");
+        return false;
+    }
+    auto seq = h->seq_.load(std::memory_order_acquire);
+    if (seq & broken_flag) return false;
+    auto next = (seq + 1) & phase_mask;
+    // the seat might have arrived already, with the dead one it has been taken over from
+    if (h->members_.done(p->slot_) != next) {
+        h->members_.mark(p->slot_, next);
+        if (h->arrived_.fetch_add(1, std::memory_order_acq_rel) + 1 == expected) {
+            // the last one: begins the next phase, unless it has been broken meanwhile
+            h->arrived_.store(0, std::memory_order_relaxed);
+            if (!h->seq_.compare_exchange_strong(seq, next, std::memory_order_acq_rel)) {
+                return false;
+            }
+            ipc::detail::sync::wake_word(h->seq_);
+            return true;
+        }
+    }
+    if (!ipc::detail::sync::wait_phase(h->seq_, seq, tm, [h, next] {
+            return !h->members_.dead_owing(next);
+        })) {
+        p->break_it();
+        return false;
+    }
+    return (h->seq_.load(std::memory_order_acquire) & phase_mask) != seq;
+}
+
+bool barrier::broken() const noexcept {
+    auto h = impl(p_)->h_;
+    return (h != nullptr) && (h->seq_.load(std::memory_order_acquire) & broken_flag);
+}
+
+} // namespace sync
+} // namespace ipc
@@ -8,18 +8,26 @@
 #include "libipc/platform/win/condition.h"
 #elif defined(IPC_OS_LINUX_)
 #include "libipc/platform/linux/condition.h"
+#include "libipc/platform/posix/condition.h"
 #elif defined(IPC_OS_QNX_)
 #include "libipc/platform/posix/condition.h"
 #else/*IPC_OS*/
 #   error "Unsupported platform."
 #endif
+#include "libipc/sync/backend.h"
 
 namespace ipc {
 namespace sync {
 
 class condition::condition_ : public ipc::pimpl<condition_> {
 public:
-    ipc::detail::sync::condition cond_;
+#if defined(IPC_OS_LINUX_)
+    ipc::detail::sync::backend_obj<ipc::detail::sync::condition, ipc::detail::posix::condition> cond_;
+#elif defined(IPC_OS_QNX_)
+    ipc::detail::sync::backend_obj<ipc::detail::posix::condition> cond_;
+#else
+    ipc::detail::sync::backend_obj<ipc::detail::sync::condition> cond_;
+#endif
 };
 
 condition::condition()
@@ -37,15 +45,15 @@ condition::~condition() {
 }
 
 void const *condition::native() const noexcept {
-    return impl(p_)->cond_.native();
+    return impl(p_)->cond_.visit([](auto const &cv) -> void const * { return cv.native(); });
 }
 
 void *condition::native() noexcept {
-    return impl(p_)->cond_.native();
+    return impl(p_)->cond_.visit([](auto &cv) -> void * { return cv.native(); });
 }
 
 bool condition::valid() const noexcept {
-    return impl(p_)->cond_.valid();
+    return impl(p_)->cond_.visit([](auto const &cv) { return cv.valid(); });
 }
 
 bool condition::open(char const *name) noexcept {
@@ -57,15 +65,15 @@ void condition::close() noexcept {
 }
 
 bool condition::wait(ipc::sync::mutex &mtx, std::uint64_t tm) noexcept {
-    return impl(p_)->cond_.wait(mtx, tm);
+    return impl(p_)->cond_.visit([&mtx, tm](auto &cv) { return cv.wait(mtx, tm); });
 }
 
 bool condition::notify(ipc::sync::mutex &mtx) noexcept {
-    return impl(p_)->cond_.notify(mtx);
+    return impl(p_)->cond_.visit([&mtx](auto &cv) { return cv.notify(mtx); });
 }
 
 bool condition::broadcast(ipc::sync::mutex &mtx) noexcept {
-    return impl(p_)->cond_.broadcast(mtx);
+    return impl(p_)->cond_.visit([&mtx](auto &cv) { return cv.broadcast(mtx); });
 }
 
 } // namespace sync
@@ -0,0 +1,192 @@
+
+#include <atomic>
+
+#include "libipc/latch.h"
+#include "libipc/shm.h"
+
+#include "libipc/utility/pimpl.h"
+#include "libipc/utility/log.h"
+#include "libipc/memory/resource.h"
+#include "libipc/sync/participants.h"
+
+namespace {
+
+enum : std::uint32_t {
+    latch_closed,
+    latch_opened,
+    latch_broken
+};
+
+enum : std::uint32_t {
+    inited_flag    = 0x80000000u,
+    resetting_flag = 0x40000000u,
+    count_mask     = ~(inited_flag | resetting_flag)
+};
+
+struct latch_t {
+    std::atomic<std::uint32_t> state_; // waited on
+    std::atomic<std::uint32_t> count_; // inited_flag once the first one opens it
+    ipc::detail::sync::participants members_; // the part is the count-downs still owed
+
+    std::uint32_t wait_reset() const noexcept {
+        auto curr = count_.load(std::memory_order_acquire);
+        for (unsigned k = 0; curr & resetting_flag; curr = count_.load(std::memory_order_acquire)) {
+            ipc::yield(k);
+        }
+        return curr;
+    }
+
+    /**
+     * Starts over if nobody alive has it open, and it has settled or a dead one still owed:
+     * the next one opening it with a count inits it again.
+    */
+    void renew() noexcept {
+        auto curr = wait_reset();
+        if (((curr & inited_flag) == 0) || members_.any_alive()) return;
+        if ((state_.load(std::memory_order_acquire) == latch_closed) && !members_.dead_owing(0)) return;
+        if (!count_.compare_exchange_strong(curr, resetting_flag, std::memory_order_acq_rel)) {
+            wait_reset(); // somebody else is at it
+            return;
+        }
+        members_.reset();
+        state_.store(latch_closed, std::memory_order_relaxed);
+        count_.store(0, std::memory_order_release);
+    }
+
+    void settle(std::uint32_t state) noexcept {
+        std::uint32_t closed = latch_closed;
+        if (state_.compare_exchange_strong(closed, state, std::memory_order_acq_rel)) {
+            ipc::detail::sync::wake_word(state_);
+        }
+    }
+};
+
+} // internal-linkage
+
+namespace ipc {
+namespace sync {
+
+class latch::latch_ : public ipc::pimpl<latch_> {
+public:
+    ipc::shm::handle shm_;
+    latch_t *        h_    = nullptr;
+    std::uint32_t    slot_ = ipc::detail::sync::participants::max_count;
+};
+
+latch::latch()
+    : p_(p_->make()) {
+}
+
+latch::latch(char const *name, std::uint32_t count, std::uint32_t owes)
+    : latch() {
+    open(name, count, owes);
+}
+
+latch::~latch() {
+    close();
+    p_->clear();
+}
+
+void const *latch::native() const noexcept {
+    return impl(p_)->h_;
+}
+
+void *latch::native() noexcept {
+    return impl(p_)->h_;
+}
+
+bool latch::valid() const noexcept {
+    return impl(p_)->h_ != nullptr;
+}
+
+bool latch::open(char const *name, std::uint32_t count, std::uint32_t owes) noexcept {
+    close();
+    auto p = impl(p_);
+    if ((name == nullptr) || (name[0] == '\0') || (count & ~count_mask)) {
+        ipc::error("fail: latch::open(%s, %u)\n", name, count);
+        return false;
+    }
+    if (!p->shm_.acquire((ipc::string{"__LATCH__"} + name).c_str(), sizeof(latch_t))) {
+        ipc::error("[latch::open] fail shm.acquire: %s\n", name);
+        return false;
+    }
+    auto h = static_cast<latch_t *>(p->shm_.get());
+    // left behind by processes which are all gone
+    h->renew();
+    std::uint32_t none = 0;
+    bool first = (count != 0) && h->count_.compare_exchange_strong(none, count | inited_flag, std::memory_order_acq_rel);
+    if (!first && ((h->count_.load(std::memory_order_acquire) & inited_flag) == 0)) {
+        ipc::error("fail: latch::open(%s), the count is unknown.\n", name);
+        p->shm_.release();
+        return false;
+    }
+    // taking the slot of a dead one, which breaks the latch if it still owed anything
+    if ((p->slot_ = h->members_.join(owes, [h, owes](std::uint32_t owed) {
+            if (owed != 0) h->settle(latch_broken);
+            return owes;
+        })) >= ipc::detail::sync::participants::max_count) {
+        ipc::error("fail: latch::open(%s), too many participants.\n", name);
+        p->shm_.release();
+        return false;
+    }
+    p->h_ = h;
+    return true;
+}
+
+void latch::close() noexcept {
+    auto p = impl(p_);
+    if (p->h_ == nullptr) return;
+    p->h_->members_.leave(p->slot_);
+    p->slot_ = ipc::detail::sync::participants::max_count;
+    p->h_ = nullptr;
+    p->shm_.release();
+}
+
+bool latch::count_down(std::uint32_t n) noexcept {
+    auto p = impl(p_);
+    if (!valid()) return false;
+    auto h = p->h_;
+    auto curr = h->count_.load(std::memory_order_acquire);
+    for (;;) {
+        if ((curr & count_mask) < n) {
+            ipc::error("fail: latch::count_down(%u), the count is %u\n", n, curr & count_mask);
+            return false;
+        }
+        if (h->count_.compare_exchange_weak(curr, curr - n, std::memory_order_acq_rel)) break;
+    }
+    h->members_.pay(p->slot_, n);
+    if ((curr & count_mask) == n) {
+        h->settle(latch_opened);
+    }
+    return true;
+}
+
+bool latch::try_wait() const noexcept {
+    auto h = impl(p_)->h_;
+    return (h != nullptr) && (h->state_.load(std::memory_order_acquire) == latch_opened);
+}
+
+bool latch::wait(std::uint64_t tm) noexcept {
+    auto p = impl(p_);
+    if (!valid()) return false;
+    auto h = p->h_;
+    if (!ipc::detail::sync::wait_phase(h->state_, latch_closed, tm, [h] {
+            return !h->members_.dead_owing(0);
+        })) {
+        if (h->members_.dead_owing(0)) h->settle(latch_broken);
+        return false;
+    }
+    return h->state_.load(std::memory_order_acquire) == latch_opened;
+}
+
+bool latch::arrive_and_wait(std::uint32_t n, std::uint64_t tm) noexcept {
+    return count_down(n) && wait(tm);
+}
+
+bool latch::broken() const noexcept {
+    auto h = impl(p_)->h_;
+    return (h != nullptr) && (h->state_.load(std::memory_order_acquire) == latch_broken);
+}
+
+} // namespace sync
+} // namespace ipc
@@ -8,27 +8,35 @@
 #include "libipc/platform/win/mutex.h"
 #elif defined(IPC_OS_LINUX_)
 #include "libipc/platform/linux/mutex.h"
+#include "libipc/platform/posix/mutex.h"
 #elif defined(IPC_OS_QNX_)
 #include "libipc/platform/posix/mutex.h"
 #else/*IPC_OS*/
 #   error "Unsupported platform."
 #endif
+#include "libipc/sync/backend.h"
 
 namespace ipc {
 namespace sync {
 
 class mutex::mutex_ : public ipc::pimpl<mutex_> {
 public:
-    ipc::detail::sync::mutex lock_;
+#if defined(IPC_OS_LINUX_)
+    ipc::detail::sync::backend_obj<ipc::detail::sync::mutex, ipc::detail::posix::mutex> lock_;
+#elif defined(IPC_OS_QNX_)
+    ipc::detail::sync::backend_obj<ipc::detail::posix::mutex> lock_;
+#else
+    ipc::detail::sync::backend_obj<ipc::detail::sync::mutex> lock_;
+#endif
 };
 
 mutex::mutex()
     : p_(p_->make()) {
 }
 
-mutex::mutex(char const * name)
+mutex::mutex(char const * name, bool prio_inherit)
     : mutex() {
-    open(name);
+    open(name, prio_inherit);
 }
 
 mutex::~mutex() {
@@ -37,19 +45,19 @@ mutex::~mutex() {
 }
 
 void const *mutex::native() const noexcept {
-    return impl(p_)->lock_.native();
+    return impl(p_)->lock_.visit([](auto const &lc) -> void const * { return lc.native(); });
 }
 
 void *mutex::native() noexcept {
-    return impl(p_)->lock_.native();
+    return impl(p_)->lock_.visit([](auto &lc) -> void * { return lc.native(); });
 }
 
 bool mutex::valid() const noexcept {
-    return impl(p_)->lock_.valid();
+    return impl(p_)->lock_.visit([](auto const &lc) { return lc.valid(); });
 }
 
-bool mutex::open(char const *name) noexcept {
-    return impl(p_)->lock_.open(name);
+bool mutex::open(char const *name, bool prio_inherit) noexcept {
+    return impl(p_)->lock_.open(name, prio_inherit);
 }
 
 void mutex::close() noexcept {
@@ -57,15 +65,15 @@ void mutex::close() noexcept {
 }
 
 bool mutex::lock(std::uint64_t tm) noexcept {
-    return impl(p_)->lock_.lock(tm);
+    return impl(p_)->lock_.visit([tm](auto &lc) { return lc.lock(tm); });
 }
 
 bool mutex::try_lock() noexcept(false) {
-    return impl(p_)->lock_.try_lock();
+    return impl(p_)->lock_.visit([](auto &lc) { return lc.try_lock(); });
 }
 
 bool mutex::unlock() noexcept {
-    return impl(p_)->lock_.unlock();
+    return impl(p_)->lock_.visit([](auto &lc) { return lc.unlock(); });
 }
 
 } // namespace sync
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <utility>
+
+#include "libipc/def.h"
+#include "libipc/rw_lock.h"
+
+#include "libipc/platform/detail.h"
+#if defined(IPC_OS_WINDOWS_)
+#include "libipc/platform/win/wait_word.h"
+#elif defined(IPC_OS_LINUX_)
+#include "libipc/platform/linux/wait_word.h"
+#elif defined(IPC_OS_QNX_)
+#include "libipc/platform/posix/wait_word.h"
+#else/*IPC_OS*/
+#   error "Unsupported platform."
+#endif
+
+namespace ipc {
+namespace detail {
+namespace sync {
+
+/**
+ * The processes taking part in a barrier or a latch, in shared memory,
+ * so that the ones which died before having done their part could be noticed.
+*/
+struct participants {
+    enum : std::uint32_t {
+        max_count = 64
+    };
+
+    std::atomic<std::uint32_t> pid_ [max_count];
+    std::atomic<std::uint32_t> done_[max_count]; // the latest part done, its meaning is up to the user
+
+    /**
+     * Takes a free slot, with 'part' as its first part done.
+     * If there is none, takes over the one of a dead process: 'gone' is told the part that one
+     * had done (it might have to break the object then), and returns the part for the new owner.
+     * Returns the slot taken, or max_count if all of them are in use.
+    */
+    template <typename F>
+    std::uint32_t join(std::uint32_t part, F &&gone) noexcept {
+        auto pid = this_process();
+        for (std::uint32_t i = 0; i < max_count; ++i) {
+            std::uint32_t none = 0;
+            if (pid_[i].compare_exchange_strong(none, pid, std::memory_order_acq_rel)) {
+                done_[i].store(part, std::memory_order_release);
+                return i;
+            }
+        }
+        for (std::uint32_t i = 0; i < max_count; ++i) {
+            auto dead = pid_[i].load(std::memory_order_acquire);
+            if ((dead == 0) || process_alive(dead)) continue;
+            auto done = done_[i].load(std::memory_order_acquire);
+            if (pid_[i].compare_exchange_strong(dead, pid, std::memory_order_acq_rel)) {
+                done_[i].store(std::forward<F>(gone)(done), std::memory_order_release);
+                return i;
+            }
+        }
+        return max_count;
+    }
+
+    /// Whether any process taking part is still alive.
+    bool any_alive() const noexcept {
+        for (std::uint32_t i = 0; i < max_count; ++i) {
+            auto pid = pid_[i].load(std::memory_order_acquire);
+            if ((pid != 0) && process_alive(pid)) return true;
+        }
+        return false;
+    }
+
+    /// Frees all the slots, for starting over once nobody alive takes part.
+    void reset() noexcept {
+        for (std::uint32_t i = 0; i < max_count; ++i) {
+            pid_ [i].store(0, std::memory_order_relaxed);
+            done_[i].store(0, std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    void leave(std::uint32_t i) noexcept {
+        if (i < max_count) pid_[i].store(0, std::memory_order_release);
+    }
+
+    std::uint32_t done(std::uint32_t i) const noexcept {
+        return (i < max_count) ? done_[i].load(std::memory_order_acquire) : 0;
+    }
+
+    void mark(std::uint32_t i, std::uint32_t part) noexcept {
+        if (i < max_count) done_[i].store(part, std::memory_order_release);
+    }
+
+    /// Takes 'n' off the part of slot 'i', for the users counting the parts left down to 0.
+    void pay(std::uint32_t i, std::uint32_t n) noexcept {
+        if (i >= max_count) return;
+        auto curr = done_[i].load(std::memory_order_acquire);
+        while (!done_[i].compare_exchange_weak(curr, (curr < n) ? 0 : (curr - n), std::memory_order_acq_rel)) ;
+    }
+
+    /// Whether a participant has died without having done 'part'.
+    bool dead_owing(std::uint32_t part) const noexcept {
+        for (std::uint32_t i = 0; i < max_count; ++i) {
+            auto pid = pid_[i].load(std::memory_order_acquire);
+            if ((pid == 0) || (done_[i].load(std::memory_order_acquire) == part)) continue;
+            if (!process_alive(pid)) return true;
+        }
+        return false;
+    }
+};
+
+/**
+ * Waits until 'word' is no longer 'val': spins a little, then sleeps on it in slices.
+ * Between the slices 'check' is called, which could give up waiting by returning false.
+ * Returns false if timeout, or given up.
+*/
+template <typename F>
+bool wait_phase(std::atomic<std::uint32_t> &word, std::uint32_t val, std::uint64_t tm, F &&check) {
+    for (unsigned k = 0; k < 32;) {
+        if (word.load(std::memory_order_acquire) != val) return true;
+        ipc::yield(k);
+    }
+    constexpr std::uint64_t slice = 100; // ms
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(tm);
+    for (;;) {
+        if (word.load(std::memory_order_acquire) != val) return true;
+        if (!check()) return false;
+        std::uint64_t wait = slice;
+        if (tm != ipc::invalid_value) {
+            auto now = std::chrono::steady_clock::now();
+            if (now >= deadline) return false;
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count();
+            wait = (std::min)(slice, static_cast<std::uint64_t>(left) + 1);
+        }
+        wait_word(word, val, wait);
+    }
+}
+
+} // namespace sync
+} // namespace detail
+} // namespace ipc
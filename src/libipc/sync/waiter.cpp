@@ -5,6 +5,7 @@
 #include "libipc/platform/win/mutex.h"
 #elif defined(IPC_OS_LINUX_)
 #include "libipc/platform/linux/mutex.h"
+#include "libipc/platform/posix/mutex.h"
 #elif defined(IPC_OS_QNX_)
 #include "libipc/platform/posix/mutex.h"
 #else/*IPC_OS*/
@@ -15,7 +16,14 @@ namespace ipc {
 namespace detail {
 
 void waiter::init() {
+#if defined(IPC_OS_LINUX_)
+    ipc::detail::sync::mutex::init();
+    ipc::detail::posix::mutex::init();
+#elif defined(IPC_OS_QNX_)
+    ipc::detail::posix::mutex::init();
+#else
     ipc::detail::sync::mutex::init();
+#endif
 }
 
 } // namespace detail
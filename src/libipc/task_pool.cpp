@@ -0,0 +1,286 @@
+
+#include <atomic>
+#include <limits>
+#include <chrono>
+
+#include "libipc/task_pool.h"
+#include "libipc/shm.h"
+#include "libipc/rw_lock.h"
+#include "libipc/waiter.h"
+
+#include "libipc/utility/pimpl.h"
+#include "libipc/utility/log.h"
+#include "libipc/utility/scope_guard.h"
+#include "libipc/utility/utility.h"
+#include "libipc/memory/resource.h"
+#include "libipc/platform/detail.h"
+#if defined(IPC_OS_WINDOWS_)
+#include "libipc/platform/win/wait_word.h"
+#elif defined(IPC_OS_LINUX_)
+#include "libipc/platform/linux/wait_word.h"
+#elif defined(IPC_OS_QNX_)
+#include "libipc/platform/posix/wait_word.h"
+#endif
+
+namespace {
+
+using task_t  = ipc::task_pool::task_t;
+using index_t = std::int64_t;
+
+struct head_t {
+    std::atomic<std::uint32_t> epoch_;    // pushed times, for parking
+    std::atomic<std::uint32_t> sleepers_; // parked workers
+};
+
+struct deque_t {
+    alignas(ipc::cache_line_size) std::atomic<index_t> top_;
+    alignas(ipc::cache_line_size) std::atomic<index_t> bottom_;
+    std::atomic<std::uint32_t> owner_; // the process of the worker, 0 if the deque is free
+    // the tasks follow
+};
+
+constexpr std::size_t aligned(std::size_t size, std::size_t alignment) noexcept {
+    return ((size - 1) & ~(alignment - 1)) + alignment;
+}
+
+} // internal-linkage
+
+namespace ipc {
+
+class task_pool::task_pool_ : public ipc::pimpl<task_pool_> {
+public:
+    ipc::shm::handle    shm_;
+    ipc::detail::waiter waiter_;
+    std::size_t         cap_    = 0;
+    std::size_t         stride_ = 0;
+    std::size_t         index_  = max_workers;
+    std::size_t         victim_ = 0;
+
+    head_t * head() const noexcept {
+        return static_cast<head_t *>(shm_.get());
+    }
+
+    deque_t * deque(std::size_t i) const noexcept {
+        return reinterpret_cast<deque_t *>(
+            static_cast<byte_t *>(shm_.get()) + aligned(sizeof(head_t), alignof(deque_t)) + stride_ * i);
+    }
+
+    std::atomic<task_t> & at(deque_t * d, index_t i) const noexcept {
+        auto tasks = reinterpret_cast<std::atomic<task_t> *>(reinterpret_cast<byte_t *>(d) + sizeof(deque_t));
+        return tasks[static_cast<std::size_t>(i) & (cap_ - 1)];
+    }
+
+    bool push(task_t task) noexcept {
+        auto d = deque(index_);
+        auto b = d->bottom_.load(std::memory_order_relaxed);
+        auto t = d->top_   .load(std::memory_order_acquire);
+        if (b - t >= static_cast<index_t>(cap_)) {
+            return false;
+        }
+        at(d, b).store(task, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        d->bottom_.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool pop(task_t & task) noexcept {
+        auto d = deque(index_);
+        auto b = d->bottom_.load(std::memory_order_relaxed) - 1;
+        d->bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto t = d->top_.load(std::memory_order_relaxed);
+        if (t > b) {
+            // empty
+            d->bottom_.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+        task = at(d, b).load(std::memory_order_relaxed);
+        if (t == b) {
+            // the last one, race with thieves
+            bool won = d->top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                                 std::memory_order_relaxed);
+            d->bottom_.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    bool steal_from(deque_t * d, task_t & task) noexcept {
+        auto t = d->top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto b = d->bottom_.load(std::memory_order_acquire);
+        if (t >= b) return false;
+        task = at(d, t).load(std::memory_order_relaxed);
+        return d->top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                         std::memory_order_relaxed);
+    }
+
+    bool steal(task_t & task) noexcept {
+        // start from where the last steal succeeded
+        for (std::size_t n = 0; n < max_workers; ++n) {
+            std::size_t i = (victim_ + n) % max_workers;
+            if (i == index_) continue;
+            if (steal_from(deque(i), task)) {
+                victim_ = i;
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+task_pool::task_pool()
+    : p_(p_->make()) {
+}
+
+task_pool::task_pool(char const * name, std::size_t capacity)
+    : task_pool() {
+    open(name, capacity);
+}
+
+task_pool::~task_pool() {
+    close();
+    p_->clear();
+}
+
+bool task_pool::valid() const noexcept {
+    return impl(p_)->shm_.valid() && (impl(p_)->index_ < max_workers);
+}
+
+bool task_pool::open(char const * name, std::size_t capacity) {
+    close();
+    if ((name == nullptr) || (name[0] == '\0') || (capacity == 0)) {
+        ipc::error("fail: task_pool::open(%s, %zd)\n", name, capacity);
+        return false;
+    }
+    ipc::detail::waiter::init();
+    auto p = impl(p_);
+    p->cap_ = 1;
+    while (p->cap_ < capacity) p->cap_ <<= 1;
+    p->stride_ = aligned(sizeof(deque_t) + sizeof(task_t) * p->cap_, alignof(deque_t));
+    ipc::string prefix = "__WS_CONN__" + ipc::to_string(p->cap_) + "__";
+    if (!p->shm_.acquire((prefix + name).c_str(),
+                         aligned(sizeof(head_t), alignof(deque_t)) + p->stride_ * max_workers)) {
+        return false;
+    }
+    if (!p->waiter_.open((prefix + name).c_str())) {
+        p->shm_.release();
+        return false;
+    }
+    // take a free deque, or the one of a dead worker
+    auto pid = ipc::detail::sync::this_process();
+    for (std::size_t i = 0; (i < max_workers) && (p->index_ >= max_workers); ++i) {
+        std::uint32_t none = 0;
+        if (p->deque(i)->owner_.compare_exchange_strong(none, pid, std::memory_order_acq_rel)) {
+            p->index_ = i;
+        }
+    }
+    for (std::size_t i = 0; (i < max_workers) && (p->index_ >= max_workers); ++i) {
+        auto dead = p->deque(i)->owner_.load(std::memory_order_acquire);
+        if ((dead == 0) || ipc::detail::sync::process_alive(dead)) continue;
+        if (p->deque(i)->owner_.compare_exchange_strong(dead, pid, std::memory_order_acq_rel)) {
+            p->index_ = i;
+        }
+    }
+    if (p->index_ >= max_workers) {
+        ipc::error("fail: task_pool::open, too many workers.\n");
+        close();
+        return false;
+    }
+    // a worker which died inside pop might have left bottom_ below top_
+    auto d = p->deque(p->index_);
+    auto t = d->top_.load(std::memory_order_acquire);
+    if (d->bottom_.load(std::memory_order_relaxed) < t) {
+        d->bottom_.store(t, std::memory_order_release);
+    }
+    p->victim_ = (p->index_ + 1) % max_workers;
+    return true;
+}
+
+void task_pool::close() noexcept {
+    auto p = impl(p_);
+    if (!p->shm_.valid()) return;
+    if (p->index_ < max_workers) {
+        // the tasks left are still there for stealing
+        p->deque(p->index_)->owner_.store(0, std::memory_order_release);
+        p->index_ = max_workers;
+    }
+    p->waiter_.close();
+    p->shm_.release();
+}
+
+std::size_t task_pool::index() const noexcept {
+    return impl(p_)->index_;
+}
+
+bool task_pool::push(task_t task) {
+    auto p = impl(p_);
+    if (!valid()) {
+        ipc::error("fail: task_pool::push, not opened.\n");
+        return false;
+    }
+    if (!p->push(task)) {
+        return false;
+    }
+    // a parked worker must either see the new epoch, or be seen here
+    p->head()->epoch_.fetch_add(1, std::memory_order_seq_cst);
+    if (p->head()->sleepers_.load(std::memory_order_seq_cst) != 0) {
+        p->waiter_.broadcast();
+    }
+    return true;
+}
+
+bool task_pool::pop(task_t & task) {
+    return valid() && impl(p_)->pop(task);
+}
+
+bool task_pool::steal(task_t & task) {
+    return valid() && impl(p_)->steal(task);
+}
+
+bool task_pool::take(task_t & task, std::uint64_t tm) {
+    auto p = impl(p_);
+    if (!valid()) {
+        ipc::error("fail: task_pool::take, not opened.\n");
+        return false;
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned k = 0;;) {
+        if (p->pop(task) || p->steal(task)) return true;
+        if (tm == 0) return false;
+        if (k < 32) {
+            ipc::yield(k);
+            continue;
+        }
+        // every park waits only for what is left of 'tm'
+        std::uint64_t left = tm;
+        if (tm != ipc::invalid_value) {
+            auto spent = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                             std::chrono::steady_clock::now() - start).count());
+            if (spent >= tm) return false;
+            left = tm - spent;
+        }
+        auto epoch = p->head()->epoch_.load(std::memory_order_seq_cst);
+        p->head()->sleepers_.fetch_add(1, std::memory_order_seq_cst);
+        IPC_UNUSED_ auto finally = ipc::guard([p] {
+            p->head()->sleepers_.fetch_sub(1, std::memory_order_relaxed);
+        });
+        // check again after being counted, so no push could be missed
+        if (p->pop(task) || p->steal(task)) return true;
+        if (!p->waiter_.wait_if([p, epoch] {
+                return p->head()->epoch_.load(std::memory_order_seq_cst) == epoch;
+            }, left)) {
+            return false;
+        }
+        if (p->head()->epoch_.load(std::memory_order_relaxed) == epoch) {
+            return false; // quit waiting
+        }
+        k = 0;
+    }
+}
+
+void task_pool::quit_waiting() {
+    impl(p_)->waiter_.quit_waiting();
+}
+
+} // namespace ipc
@@ -3,6 +3,8 @@
 #include <type_traits>  // std::aligned_storage_t
 #include <cstring>      // std::memcmp
 #include <cstdint>
+#include <atomic>
+#include <limits>
 
 #include "libipc/def.h"
 #include "libipc/platform/detail.h"
@@ -100,4 +102,232 @@ public:
     T const * at(storage_id_t id) const { return reinterpret_cast<T const *>(base_t::at(id)); }
 };
 
+template <std::size_t DataSize, std::size_t AlignSize>
+struct slab_node {
+    std::atomic<std::uint32_t> next_;  // id + 1, 0 means the end
+    std::atomic<std::uint32_t> owner_; // the process caching the id in a magazine, 0 if none
+    std::aligned_storage_t<DataSize, AlignSize> data_;
+};
+
+template <std::size_t AlignSize>
+struct slab_node<0, AlignSize> {
+    std::atomic<std::uint32_t> next_;
+    std::atomic<std::uint32_t> owner_;
+};
+
+/**
+ * A lock-free slab of fixed-size blocks, which could be placed in shared memory directly.
+ * Zero-initialized memory is an empty slab: unused ids are handed out by a bump counter,
+ * released ids go to a free list whose head is tagged against ABA.
+ * A DataSize of 0 makes it a bare id allocator, for blocks stored elsewhere.
+*/
+template <std::size_t DataSize,
+          std::size_t AlignSize = (ipc::detail::min)(DataSize, alignof(std::max_align_t)),
+          std::size_t Count     = 4096>
+class id_slab {
+    static_assert(Count > 0 && Count < (std::numeric_limits<std::uint32_t>::max)(), "Count is out of range.");
+
+    // low 32 bits: id + 1 of the first free node, high 32 bits: tag
+    std::atomic<std::uint64_t> head_ {0};
+    std::atomic<std::uint32_t> bump_ {0};
+    slab_node<DataSize, AlignSize> nodes_[Count] {};
+
+    static constexpr std::uint64_t make_head(std::uint64_t old, std::uint32_t next) noexcept {
+        return ((old & ~0xffffffffull) + 0x100000000ull) | next;
+    }
+
+    static bool valid(storage_id_t id) noexcept {
+        return (id >= 0) && (static_cast<std::size_t>(id) < Count);
+    }
+
+public:
+    enum : std::size_t {
+        max_count = Count
+    };
+
+    /// Returns -1 if the slab is exhausted.
+    storage_id_t acquire() noexcept {
+        storage_id_t id;
+        return (acquire(&id, 1) == 0) ? -1 : id;
+    }
+
+    /// Takes up to n ids, the ones on the free list with a single CAS. Returns the count.
+    std::size_t acquire(storage_id_t *ids, std::size_t n) noexcept {
+        std::size_t k = 0;
+        auto old = head_.load(std::memory_order_acquire);
+        for (;;) {
+            auto curr = static_cast<std::uint32_t>(old);
+            // might walk stale 'next's here, but then the tag has changed and CAS fails
+            for (k = 0; (k < n) && (curr != 0); ++k) {
+                ids[k] = static_cast<storage_id_t>(curr - 1);
+                curr   = nodes_[curr - 1].next_.load(std::memory_order_relaxed);
+            }
+            if (k == 0) break;
+            if (head_.compare_exchange_weak(old, make_head(old, curr),
+                                            std::memory_order_acquire, std::memory_order_acquire)) {
+                break;
+            }
+        }
+        // the free list is short, take the blocks that have never been used
+        auto b = bump_.load(std::memory_order_relaxed);
+        while ((k < n) && (b < Count)) {
+            if (bump_.compare_exchange_weak(b, b + 1, std::memory_order_relaxed)) {
+                ids[k++] = static_cast<storage_id_t>(b++);
+            }
+        }
+        return k;
+    }
+
+    bool release(storage_id_t id) noexcept {
+        return release(&id, 1) == 1;
+    }
+
+    /// Gives back n ids with a single CAS, the invalid ones are skipped. Returns the count.
+    std::size_t release(storage_id_t const *ids, std::size_t n) noexcept {
+        // chain the ids up first
+        std::uint32_t first = 0, last = 0;
+        std::size_t k = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            if (!valid(ids[i])) continue;
+            auto curr = static_cast<std::uint32_t>(ids[i]) + 1;
+            if (last == 0) first = curr;
+            else nodes_[last - 1].next_.store(curr, std::memory_order_relaxed);
+            last = curr;
+            ++k;
+        }
+        if (k == 0) return 0;
+        auto old = head_.load(std::memory_order_relaxed);
+        do {
+            nodes_[last - 1].next_.store(static_cast<std::uint32_t>(old), std::memory_order_relaxed);
+        } while (!head_.compare_exchange_weak(old, make_head(old, first),
+                                              std::memory_order_release, std::memory_order_relaxed));
+        return k;
+    }
+
+    /// Marks an id as cached by the process 'owner' (see: slab_magazine).
+    void cache(storage_id_t id, std::uint32_t owner) noexcept {
+        nodes_[id].owner_.store(owner, std::memory_order_release);
+    }
+
+    /// Takes an id out of the cache of 'owner', fails if it has been reclaimed meanwhile.
+    bool uncache(storage_id_t id, std::uint32_t owner) noexcept {
+        return nodes_[id].owner_.compare_exchange_strong(owner, 0, std::memory_order_acq_rel);
+    }
+
+    /**
+     * Gives the cached ids whose owner satisfies 'pred' back to the slab,
+     * e.g. the ones of a dead process. Returns the count.
+    */
+    template <typename F>
+    std::size_t reclaim(F &&pred) noexcept {
+        std::size_t k = 0;
+        auto used = ipc::detail::min<std::size_t>(bump_.load(std::memory_order_acquire), Count);
+        for (std::size_t i = 0; i < used; ++i) {
+            auto owner = nodes_[i].owner_.load(std::memory_order_acquire);
+            if ((owner == 0) || !pred(owner)) continue;
+            // only one of the reclaimers (or the owner itself) clears the mark
+            if (nodes_[i].owner_.compare_exchange_strong(owner, 0, std::memory_order_acq_rel)) {
+                release(static_cast<storage_id_t>(i));
+                ++k;
+            }
+        }
+        return k;
+    }
+
+    void       * at(storage_id_t id)       noexcept { return &(nodes_[id].data_); }
+    void const * at(storage_id_t id) const noexcept { return &(nodes_[id].data_); }
+};
+
+template <typename T, std::size_t Count = 4096>
+class obj_slab : public id_slab<sizeof(T), alignof(T), Count> {
+    using base_t = id_slab<sizeof(T), alignof(T), Count>;
+
+public:
+    T       * at(storage_id_t id)       noexcept { return reinterpret_cast<T       *>(base_t::at(id)); }
+    T const * at(storage_id_t id) const noexcept { return reinterpret_cast<T const *>(base_t::at(id)); }
+};
+
+/**
+ * A per-process (not thread-safe) cache of ids in front of a shared slab.
+ * Ids are taken from & given back to the slab in batches of N / 2,
+ * and all cached ids are returned by flush() or the destructor.
+ * With an 'owner' function, the cached ids are marked with its result (e.g. the pid),
+ * so that the slab could reclaim them if the process dies (see: id_slab::reclaim);
+ * it is called on every use, so a forked child doesn't take the ids of its parent.
+*/
+template <typename Slab, std::size_t N = 32>
+class slab_magazine {
+    static_assert(N >= 2, "N is too small.");
+
+    Slab *slab_ = nullptr;
+    std::uint32_t (*owner_)() noexcept = nullptr;
+    storage_id_t ids_[N];
+    std::size_t  size_ = 0;
+
+    std::uint32_t owner() const noexcept {
+        return (owner_ == nullptr) ? 0 : owner_();
+    }
+
+    /// Gives back the cached ids from 'from' up to the top.
+    void drain(std::size_t from) noexcept {
+        auto pid = owner();
+        std::size_t k = from;
+        for (std::size_t i = from; i < size_; ++i) {
+            // skip the ones which have been reclaimed
+            if ((pid == 0) || slab_->uncache(ids_[i], pid)) ids_[k++] = ids_[i];
+        }
+        slab_->release(ids_ + from, k - from);
+        size_ = from;
+    }
+
+public:
+    slab_magazine() = default;
+    explicit slab_magazine(Slab *slab, std::uint32_t (*owner)() noexcept = nullptr) noexcept
+        : slab_(slab), owner_(owner) {}
+
+    slab_magazine(slab_magazine const &) = delete;
+    slab_magazine &operator=(slab_magazine const &) = delete;
+
+    ~slab_magazine() { flush(); }
+
+    Slab *slab() const noexcept { return slab_; }
+    std::size_t size() const noexcept { return size_; }
+
+    void reset(Slab *slab) noexcept {
+        flush();
+        slab_ = slab;
+    }
+
+    storage_id_t acquire() noexcept {
+        if (slab_ == nullptr) return -1;
+        auto pid = owner();
+        while (size_ > 0) {
+            auto id = ids_[--size_];
+            // a reclaimed id belongs to somebody else now
+            if ((pid == 0) || slab_->uncache(id, pid)) return id;
+        }
+        // refill
+        size_ = slab_->acquire(ids_, N / 2);
+        if (size_ == 0) return -1;
+        if (pid != 0) {
+            for (std::size_t i = 0; i + 1 < size_; ++i) slab_->cache(ids_[i], pid);
+        }
+        return ids_[--size_];
+    }
+
+    bool release(storage_id_t id) noexcept {
+        if ((slab_ == nullptr) || (id < 0)) return false;
+        if (size_ == N) drain(N / 2);
+        auto pid = owner();
+        if (pid != 0) slab_->cache(id, pid);
+        ids_[size_++] = id;
+        return true;
+    }
+
+    void flush() noexcept {
+        if (slab_ == nullptr) return;
+        drain(0);
+    }
+};
+
 } // namespace ipc
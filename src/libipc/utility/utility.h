@@ -44,6 +44,17 @@ enum {
 // #endif/*__cplusplus < 201703L*/
 };
 
+/// Hints the cpu to load [p, p + size) into the cache for reading, one line at a time.
+inline void prefetch(void const * p, std::size_t size = cache_line_size) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+    auto c = static_cast<char const *>(p);
+    for (auto e = c + size; c < e; c += cache_line_size) __builtin_prefetch(c, 0, 3);
+#else
+    static_cast<void>(p);
+    static_cast<void>(size);
+#endif
+}
+
 template <typename T, typename U>
 auto horrible_cast(U rhs) noexcept
     -> typename std::enable_if<std::is_trivially_copyable<T>::value
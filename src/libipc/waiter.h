@@ -6,9 +6,11 @@
 #include <atomic>
 
 #include "libipc/def.h"
+#include "libipc/shm.h"
 #include "libipc/mutex.h"
 #include "libipc/condition.h"
 #include "libipc/platform/detail.h"
+#include "libipc/utility/scope_guard.h"
 
 namespace ipc {
 namespace detail {
@@ -16,14 +18,28 @@ namespace detail {
 class waiter {
     ipc::sync::condition cond_;
     ipc::sync::mutex     lock_;
+    ipc::shm::handle     count_h_; // the threads in wait_if, of all processes
     std::atomic<bool>    quit_ {false};
 
+    std::atomic<std::uint32_t> *counter() const noexcept {
+        return static_cast<std::atomic<std::uint32_t> *>(count_h_.get());
+    }
+
+    /// Whether anyone might be waiting, so the wake-up syscall could be skipped if not.
+    bool has_waiting() const noexcept {
+        auto cnt = counter();
+        if (cnt == nullptr) return true;
+        // pairs with the one in wait_if: either the waiter sees the new state, or we see the waiter
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return cnt->load(std::memory_order_relaxed) != 0;
+    }
+
 public:
     static void init();
 
     waiter() = default;
-    waiter(char const *name) {
-        open(name);
+    waiter(char const *name, bool prio_inherit = false) {
+        open(name, prio_inherit);
     }
 
     ~waiter() {
@@ -34,26 +50,42 @@ public:
         return cond_.valid() && lock_.valid();
     }
 
-    bool open(char const *name) noexcept {
+    /**
+     * 'prio_inherit' asks for a priority-inheriting lock (see: ipc::sync::mutex::open),
+     * taken by the first one opening it.
+    */
+    bool open(char const *name, bool prio_inherit = false) noexcept {
         quit_.store(false, std::memory_order_relaxed);
         if (!cond_.open((std::string{"_waiter_cond_"} + name).c_str())) {
             return false;
         }
-        if (!lock_.open((std::string{"_waiter_lock_"} + name).c_str())) {
+        if (!lock_.open((std::string{"_waiter_lock_"} + name).c_str(), prio_inherit)) {
             cond_.close();
             return false;
         }
+        // without the counter, every notifying just goes to the kernel
+        count_h_.acquire((std::string{"_waiter_count_"} + name).c_str(), sizeof(std::atomic<std::uint32_t>));
         return valid();
     }
 
     void close() noexcept {
         cond_.close();
         lock_.close();
+        count_h_.release();
     }
 
     template <typename F>
     bool wait_if(F &&pred, std::uint64_t tm = ipc::invalid_value) noexcept {
         IPC_UNUSED_ std::lock_guard<ipc::sync::mutex> guard {lock_};
+        // be counted before checking, so a notifier could never skip us
+        auto cnt = counter();
+        if (cnt != nullptr) {
+            cnt->fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+        IPC_UNUSED_ auto finally = ipc::guard([cnt] {
+            if (cnt != nullptr) cnt->fetch_sub(1, std::memory_order_relaxed);
+        });
         while ([this, &pred] {
                     return !quit_.load(std::memory_order_relaxed)
                         && std::forward<F>(pred)();
@@ -64,15 +96,21 @@ public:
     }
 
     bool notify() noexcept {
+        if (!has_waiting()) return true;
         std::lock_guard<ipc::sync::mutex>{lock_}; // barrier
         return cond_.notify(lock_);
     }
 
     bool broadcast() noexcept {
+        if (!has_waiting()) return true;
         std::lock_guard<ipc::sync::mutex>{lock_}; // barrier
         return cond_.broadcast(lock_);
     }
 
+    bool quitting() const noexcept {
+        return quit_.load(std::memory_order_acquire);
+    }
+
     bool quit_waiting() {
         quit_.store(true, std::memory_order_release);
         return broadcast();
@@ -0,0 +1,134 @@
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+#include "libipc/conflate.h"
+#include "libipc/platform/detail.h"
+#if !defined(IPC_OS_WINDOWS_)
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "test.h"
+
+namespace {
+
+struct update_t {
+    std::uint64_t key_;
+    int           val_;
+};
+
+} // internal-linkage
+
+TEST(Conflate, latest) {
+    constexpr int Keys = 10;
+    ipc::conflate r {"test-conflate-latest", Keys, sizeof(update_t), ipc::receiver};
+    ipc::conflate s {"test-conflate-latest", Keys, sizeof(update_t)};
+    ASSERT_TRUE(r.valid());
+    ASSERT_TRUE(s.valid());
+    for (int i = 0; i < 100; ++i) {
+        for (std::uint64_t k = 0; k < Keys; ++k) {
+            update_t u {k, i};
+            ASSERT_TRUE(s.update(k * 1000, &u, sizeof(u)));
+        }
+    }
+    EXPECT_FALSE(s.update(Keys * 1000, "x", sizeof(update_t) + 1));
+
+    // only the latest value of each key is left
+    std::vector<bool> got(Keys);
+    for (int i = 0; i < Keys; ++i) {
+        std::uint64_t key {};
+        auto buf = r.try_recv(&key);
+        ASSERT_EQ(buf.size(), sizeof(update_t));
+        auto u = buf.get<update_t const *>();
+        EXPECT_EQ(key, u->key_ * 1000);
+        EXPECT_EQ(u->val_, 99);
+        EXPECT_FALSE(got[u->key_]);
+        got[u->key_] = true;
+    }
+    EXPECT_TRUE(r.try_recv().empty());
+
+    // a late receiver starts with the latest values
+    ipc::conflate r2 {"test-conflate-latest", Keys, sizeof(update_t), ipc::receiver};
+    int count = 0;
+    while (!r2.try_recv().empty()) ++count;
+    EXPECT_EQ(count, Keys);
+}
+
+TEST(Conflate, concurrent) {
+    constexpr int Keys  = 64;
+    constexpr int Loops = 100000;
+    ipc::conflate r {"test-conflate-concurrent", Keys, sizeof(update_t), ipc::receiver};
+    ASSERT_TRUE(r.valid());
+
+    std::thread sender {[&] {
+        ipc::conflate s {"test-conflate-concurrent", Keys, sizeof(update_t)};
+        for (int i = 0; i < Loops; ++i) {
+            update_t u {static_cast<std::uint64_t>(i % Keys), i};
+            ASSERT_TRUE(s.update(u.key_, &u, sizeof(u)));
+        }
+    }};
+
+    // values never go backwards, and the last one of every key arrives
+    std::vector<int> last(Keys, -1);
+    int finished = 0, received = 0;
+    while (finished < Keys) {
+        std::uint64_t key {};
+        auto buf = r.recv(&key, 1000);
+        ASSERT_FALSE(buf.empty());
+        ++received;
+        auto u = buf.get<update_t const *>();
+        ASSERT_EQ(u->key_, key);
+        ASSERT_GT(u->val_, last[key]);
+        last[key] = u->val_;
+        if (u->val_ >= Loops - Keys) ++finished;
+    }
+    sender.join();
+    EXPECT_TRUE(r.try_recv().empty());
+    EXPECT_LE(received, Loops);
+}
+
+#if !defined(IPC_OS_WINDOWS_)
+TEST(Conflate, robust) {
+    constexpr std::size_t Size = 1024 * 1024;
+    // receivers die without closing: their bits are taken back
+    for (int i = 0; i < 40; ++i) {
+        pid_t pid = ::fork();
+        ASSERT_GE(pid, 0);
+        if (pid == 0) {
+            ipc::conflate r {"test-conflate-robust", 1, Size, ipc::receiver};
+            ::_exit(r.valid() ? 0 : 1);
+        }
+        int status = 0;
+        ASSERT_EQ(::waitpid(pid, &status, 0), pid);
+        ASSERT_EQ(WEXITSTATUS(status), 0);
+    }
+    ipc::conflate r {"test-conflate-robust", 1, Size, ipc::receiver};
+    ASSERT_TRUE(r.valid());
+
+    // a sender is killed, most likely while copying a value:
+    // the next sender takes its slot over, instead of waiting forever
+    pid_t pid = ::fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+        ipc::conflate s {"test-conflate-robust", 1, Size};
+        std::vector<char> data(Size, 'a');
+        for (;;) s.update(0, data.data(), data.size());
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ::kill(pid, SIGKILL);
+    ASSERT_EQ(::waitpid(pid, nullptr, 0), pid);
+
+    ipc::conflate s {"test-conflate-robust", 1, Size};
+    std::vector<char> data(Size, 'b');
+    ASSERT_TRUE(s.update(0, data.data(), data.size()));
+    for (;;) {
+        auto buf = r.recv(nullptr, 1000);
+        ASSERT_EQ(buf.size(), Size);
+        if (buf.get<char const *>()[Size - 1] == 'b') break;
+    }
+}
+#endif // !IPC_OS_WINDOWS_
@@ -4,16 +4,31 @@
 #include <mutex>
 #include <atomic>
 #include <cstring>
+#include <algorithm>
+#include <string>
+#include <chrono>
+#include <unordered_map>
 
 #include "libipc/ipc.h"
+#include "libipc/mux.h"
+#include "libipc/merge.h"
+#include "libipc/mutex.h"
 #include "libipc/buffer.h"
 #include "libipc/memory/resource.h"
+#include "libipc/platform/detail.h"
 
 #include "test.h"
 #include "thread_pool.h"
 
 #include "capo/random.hpp"
 
+#if defined(IPC_OS_LINUX_)
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 using namespace ipc;
 
 namespace {
@@ -183,3 +198,596 @@ TEST(IPC, NvN) {
     //test_sr<relat::multi , relat::multi , trans::unicast  >("mmu", MultiMax, MultiMax);
     test_sr<relat::multi , relat::multi , trans::broadcast>("mmb", MultiMax, MultiMax);
 }
+
+TEST(IPC, relay) {
+    constexpr int    Count = 1000;
+    constexpr size_t Size  = 4096;
+    std::vector<void const *> ptrs(Count, nullptr);
+    std::atomic<int> done {0};
+
+    std::thread final_recv {[&] {
+        ipc::channel b {"test-relay-b", ipc::receiver};
+        for (int i = 0; i < Count; ++i) {
+            auto buf = b.recv();
+            ASSERT_EQ(buf.size(), Size);
+            EXPECT_EQ(buf.get<int const *>()[0], i);
+            EXPECT_EQ(buf.get<int const *>()[Size / sizeof(int) - 1], i);
+            // the relayed message is the very same chunk
+            EXPECT_EQ(buf.data(), ptrs[i]);
+            done.fetch_add(1, std::memory_order_release);
+        }
+    }};
+    ASSERT_TRUE(ipc::channel::wait_for_recv("test-relay-b", 1));
+
+    std::thread relayer {[&] {
+        ipc::route    a {"test-relay-a", ipc::receiver};
+        ipc::channel  b {"test-relay-b", ipc::sender};
+        for (int i = 0; i < Count; ++i) {
+            auto buf = a.recv();
+            ASSERT_EQ(buf.size(), Size);
+            ptrs[i] = buf.data();
+            ASSERT_TRUE(b.relay(buf));
+        }
+    }};
+    ASSERT_TRUE(ipc::route::wait_for_recv("test-relay-a", 1));
+
+    ipc::route a {"test-relay-a", ipc::sender};
+    std::vector<int> data(Size / sizeof(int));
+    for (int i = 0; i < Count; ++i) {
+        // keep the chunks in flight fewer than large_msg_cache
+        while (i - done.load(std::memory_order_acquire) >= 8) {
+            std::this_thread::yield();
+        }
+        std::fill(data.begin(), data.end(), i);
+        ASSERT_TRUE(a.send(data.data(), Size, ipc::invalid_value));
+    }
+    relayer.join();
+    final_recv.join();
+}
+
+/**
+ * One chunk is relayed to two channels while the other receiver of the origin
+ * recycles it at the same time: the publication slots get ended & reused concurrently.
+ * A chunk freed too early would be overwritten by a later message.
+ * The window is a few instructions wide: it takes several cores to hit it.
+*/
+TEST(IPC, relay_recycle_race) {
+    constexpr int    Count = 20000;
+    constexpr size_t Size  = 4096;
+    std::atomic<int> done {0};
+
+    auto check = [](ipc::buff_t const & buf, int i) {
+        if (buf.size() != Size) return false;
+        auto p = buf.get<int const *>();
+        return std::all_of(p, p + Size / sizeof(int), [i](int v) { return v == i; });
+    };
+    auto final_reader = [&](char const * name) {
+        ipc::route r {name, ipc::receiver};
+        for (int i = 0; i < Count; ++i) {
+            auto buf = r.recv();
+            EXPECT_TRUE(check(buf, i)) << name << ": " << i;
+            done.fetch_add(1, std::memory_order_release);
+        }
+    };
+    std::thread rb {final_reader, "test-relay-race-b"};
+    std::thread rc {final_reader, "test-relay-race-c"};
+    ASSERT_TRUE(ipc::route::wait_for_recv("test-relay-race-b", 1));
+    ASSERT_TRUE(ipc::route::wait_for_recv("test-relay-race-c", 1));
+
+    std::thread relayer {[&] {
+        ipc::route a {"test-relay-race-a", ipc::receiver};
+        ipc::route b {"test-relay-race-b", ipc::sender};
+        ipc::route c {"test-relay-race-c", ipc::sender};
+        for (int i = 0; i < Count; ++i) {
+            auto buf = a.recv();
+            ASSERT_TRUE(check(buf, i)) << i;
+            ASSERT_TRUE(b.relay(buf));
+            ASSERT_TRUE(c.relay(buf));
+        }
+    }};
+    std::thread recycler {[&] {
+        ipc::route a {"test-relay-race-a", ipc::receiver};
+        for (int i = 0; i < Count; ++i) {
+            auto buf = a.recv();
+            EXPECT_TRUE(check(buf, i)) << i;
+        }
+    }};
+    ASSERT_TRUE(ipc::route::wait_for_recv("test-relay-race-a", 2));
+
+    ipc::route a {"test-relay-race-a", ipc::sender};
+    std::vector<int> data(Size / sizeof(int));
+    for (int i = 0; i < Count; ++i) {
+        // keep the chunks in flight fewer than large_msg_cache
+        while ((i * 2) - done.load(std::memory_order_acquire) >= 16) {
+            std::this_thread::yield();
+        }
+        std::fill(data.begin(), data.end(), i);
+        ASSERT_TRUE(a.send(data.data(), Size, ipc::invalid_value));
+    }
+    relayer.join();
+    recycler.join();
+    rb.join();
+    rc.join();
+}
+
+TEST(IPC, publish_all) {
+    constexpr int    Count = 1000;
+    constexpr size_t Size  = 4096;
+    std::vector<void const *> ptrs[2] {std::vector<void const *>(Count), std::vector<void const *>(Count)};
+    std::atomic<int> done {0};
+
+    auto reader = [&](char const * name, int k) {
+        ipc::route r {name, ipc::receiver};
+        for (int i = 0; i < Count; ++i) {
+            auto buf = r.recv();
+            ASSERT_EQ(buf.size(), Size);
+            EXPECT_EQ(buf.get<int const *>()[Size / sizeof(int) - 1], i);
+            ptrs[k][i] = buf.data();
+            done.fetch_add(1, std::memory_order_release);
+        }
+    };
+    std::thread r1 {reader, "test-publish-1", 0};
+    std::thread r2 {reader, "test-publish-2", 1};
+    ipc::route s1 {"test-publish-1", ipc::sender};
+    ipc::route s2 {"test-publish-2", ipc::sender};
+    ASSERT_TRUE(s1.wait_for_recv(1));
+    ASSERT_TRUE(s2.wait_for_recv(1));
+
+    std::vector<int> data(Size / sizeof(int));
+    for (int i = 0; i < Count; ++i) {
+        // keep the chunks in flight fewer than large_msg_cache
+        while ((i * 2) - done.load(std::memory_order_acquire) >= 16) {
+            std::this_thread::yield();
+        }
+        std::fill(data.begin(), data.end(), i);
+        ASSERT_TRUE(ipc::publish_all({&s1, &s2}, data.data(), Size, ipc::invalid_value));
+    }
+    r1.join();
+    r2.join();
+    // both channels got the very same chunk
+    EXPECT_EQ(ptrs[0], ptrs[1]);
+}
+
+/**
+ * A chunk fanned out by publish_all is relayed further by one receiver,
+ * while the receiver of the other channel recycles its publication at the same time.
+*/
+TEST(IPC, publish_all_relay_race) {
+    constexpr int    Count = 20000;
+    constexpr size_t Size  = 4096;
+    std::atomic<int> done {0};
+
+    auto check = [](ipc::buff_t const & buf, int i) {
+        if (buf.size() != Size) return false;
+        auto p = buf.get<int const *>();
+        return std::all_of(p, p + Size / sizeof(int), [i](int v) { return v == i; });
+    };
+    auto reader = [&](char const * name) {
+        ipc::route r {name, ipc::receiver};
+        for (int i = 0; i < Count; ++i) {
+            auto buf = r.recv();
+            EXPECT_TRUE(check(buf, i)) << name << ": " << i;
+            done.fetch_add(1, std::memory_order_release);
+        }
+    };
+    std::thread rb {reader, "test-fanout-race-b"};
+    std::thread rc {reader, "test-fanout-race-c"};
+    std::thread relayer {[&] {
+        ipc::route a {"test-fanout-race-a", ipc::receiver};
+        ipc::route c {"test-fanout-race-c", ipc::sender};
+        ASSERT_TRUE(c.wait_for_recv(1));
+        for (int i = 0; i < Count; ++i) {
+            auto buf = a.recv();
+            ASSERT_TRUE(check(buf, i)) << i;
+            ASSERT_TRUE(c.relay(buf));
+        }
+    }};
+    ipc::route sa {"test-fanout-race-a", ipc::sender};
+    ipc::route sb {"test-fanout-race-b", ipc::sender};
+    ASSERT_TRUE(sa.wait_for_recv(1));
+    ASSERT_TRUE(sb.wait_for_recv(1));
+
+    std::vector<int> data(Size / sizeof(int));
+    for (int i = 0; i < Count; ++i) {
+        // keep the chunks in flight fewer than large_msg_cache
+        while ((i * 2) - done.load(std::memory_order_acquire) >= 16) {
+            std::this_thread::yield();
+        }
+        std::fill(data.begin(), data.end(), i);
+        ASSERT_TRUE(ipc::publish_all({&sa, &sb}, data.data(), Size, ipc::invalid_value));
+    }
+    relayer.join();
+    rb.join();
+    rc.join();
+}
+
+TEST(IPC, local) {
+    constexpr int Count = 10000;
+    std::vector<void const *> ptrs(Count);
+
+    // broadcast: every receiver gets every message
+    auto reader = [&](int /*k*/) {
+        ipc::channel r {"test-local", ipc::receiver | ipc::local};
+        for (int i = 0; i < Count; ++i) {
+            auto buf = r.recv();
+            ASSERT_EQ(buf.size(), sizeof(int));
+            EXPECT_EQ(*buf.template get<int const *>(), i);
+        }
+    };
+    {
+        std::thread r1 {reader, 0};
+        ipc::channel s {"test-local", ipc::sender | ipc::local};
+        ASSERT_TRUE(s.wait_for_recv(1));
+        std::thread r2 {reader, 1};
+        ASSERT_TRUE(s.wait_for_recv(2));
+        for (int i = 0; i < Count; ++i) {
+            ASSERT_TRUE(s.send(&i, sizeof(i), ipc::invalid_value));
+        }
+        r1.join();
+        r2.join();
+        EXPECT_EQ(s.recv_count(), 0);
+    }
+    // a moved buffer is handed over as it is
+    std::thread r1 {[&] {
+        ipc::chan<relat::single, relat::single, trans::unicast> r {"test-local-uni", ipc::receiver | ipc::local};
+        for (int i = 0; i < Count; ++i) {
+            auto buf = r.recv();
+            ASSERT_EQ(buf.size(), sizeof(int));
+            EXPECT_EQ(*buf.template get<int const *>(), i);
+            EXPECT_EQ(buf.data(), ptrs[i]);
+        }
+    }};
+    ipc::chan<relat::single, relat::single, trans::unicast> s {"test-local-uni", ipc::sender | ipc::local};
+    ASSERT_TRUE(s.wait_for_recv(1));
+    for (int i = 0; i < Count; ++i) {
+        auto p = new int {i};
+        ptrs[i] = p;
+        ASSERT_TRUE(s.send(ipc::buff_t{p, sizeof(int), [](void *p, std::size_t) {
+            delete static_cast<int *>(p);
+        }}, ipc::invalid_value));
+    }
+    r1.join();
+}
+
+template <relat Rp, relat Rc, trans Ts>
+void test_spin(char const * name) {
+    constexpr int Count = 10000;
+    std::thread r1 {[name] {
+        chan<Rp, Rc, Ts> r {name, ipc::receiver | ipc::spin};
+        for (int i = 0; i < Count; ++i) {
+            auto buf = r.recv();
+            ASSERT_EQ(buf.size(), sizeof(int));
+            EXPECT_EQ(*buf.template get<int const *>(), i);
+        }
+        // times out as usual
+        EXPECT_TRUE(r.recv(10).empty());
+    }};
+    chan<Rp, Rc, Ts> s {name, ipc::sender};
+    ASSERT_TRUE(s.wait_for_recv(1));
+    for (int i = 0; i < Count; ++i) {
+        ASSERT_TRUE(s.send(&i, sizeof(i), ipc::invalid_value));
+    }
+    r1.join();
+}
+
+TEST(IPC, spin) {
+    test_spin<relat::single, relat::single, trans::unicast  >("test-spin-ssu");
+    //test_spin<relat::single, relat::multi , trans::unicast  >("test-spin-smu");
+    //test_spin<relat::multi , relat::multi , trans::unicast  >("test-spin-mmu");
+    test_spin<relat::single, relat::multi , trans::broadcast>("test-spin-smb");
+    test_spin<relat::multi , relat::multi , trans::broadcast>("test-spin-mmb");
+}
+
+TEST(IPC, prio_inherit) {
+    auto def = ipc::sync::current_backend();
+#if defined(IPC_OS_LINUX_)
+    for (auto b : {ipc::sync::backend::futex, ipc::sync::backend::pthread}) {
+#else
+    for (auto b : {def}) {
+#endif
+        ASSERT_TRUE(ipc::sync::use_backend(b));
+        {
+            ipc::route r {"test-prio-inherit", ipc::receiver | ipc::prio_inherit};
+            ipc::route s {"test-prio-inherit", ipc::sender | ipc::prio_inherit};
+            ASSERT_TRUE(s.wait_for_recv(1));
+            std::thread t {[&r] {
+                auto buf = r.recv(5000);
+                EXPECT_EQ(buf.size(), sizeof(int));
+            }};
+            int i = 1;
+            EXPECT_TRUE(s.send(&i, sizeof(i)));
+            t.join();
+        }
+    }
+    ASSERT_TRUE(ipc::sync::use_backend(def));
+}
+
+TEST(IPC, mux) {
+    constexpr int Count = 1000;
+    char const * names[] {"mux-a", "mux-b", "mux-c"};
+
+    // each receiver subscribes to one logical channel, nobody to "mux-c"
+    auto reader = [&](int k) {
+        ipc::mux r {"test-mux", ipc::receiver};
+        ASSERT_TRUE(r.subscribe(names[k]));
+        for (int i = 0; i < Count; ++i) {
+            ipc::mux::id_t id {};
+            auto buf = r.recv(ipc::invalid_value, &id);
+            ASSERT_EQ(buf.size(), sizeof(int));
+            EXPECT_EQ(id, ipc::mux::id_of(names[k]));
+            EXPECT_EQ(*buf.get<int const *>(), i * 10 + k);
+        }
+        EXPECT_TRUE(r.recv(100).empty());
+    };
+    std::thread r1 {reader, 0};
+    std::thread r2 {reader, 1};
+    ipc::mux s {"test-mux", ipc::sender};
+    ASSERT_TRUE(s.channel().wait_for_recv(2));
+    for (int i = 0; i < Count; ++i) {
+        for (int k = 2; k >= 0; --k) {
+            int n = i * 10 + k;
+            ASSERT_TRUE(s.send(names[k], &n, sizeof(n), ipc::invalid_value));
+        }
+    }
+    r1.join();
+    r2.join();
+}
+
+TEST(IPC, mux_skip_large) {
+    constexpr int Count = 200;
+    // a message in the slot, and one in a chunk
+    std::size_t const sizes[] {ipc::data_length / 2, ipc::large_msg_limit * 8};
+
+    std::thread r1 {[&] {
+        ipc::mux r {"test-mux-large", ipc::receiver};
+        ASSERT_TRUE(r.subscribe("mux-b"));
+        for (int i = 0; i < Count; ++i) {
+            for (auto size : sizes) {
+                auto buf = r.recv();
+                ASSERT_EQ(buf.size(), size);
+                EXPECT_EQ(buf.get<char const *>()[0], 'b');
+                EXPECT_EQ(buf.get<char const *>()[size - 1], static_cast<char>(i));
+            }
+        }
+    }};
+    ipc::mux s {"test-mux-large", ipc::sender};
+    ASSERT_TRUE(s.channel().wait_for_recv(1));
+    std::vector<char> data(sizes[1]);
+    for (int i = 0; i < Count; ++i) {
+        for (auto size : sizes) {
+            // the receiver skips "mux-a" without copying it
+            data[0] = 'a'; data[size - 1] = static_cast<char>(i);
+            ASSERT_TRUE(s.send("mux-a", data.data(), size, ipc::invalid_value));
+            data[0] = 'b';
+            ASSERT_TRUE(s.send("mux-b", data.data(), size, ipc::invalid_value));
+        }
+    }
+    r1.join();
+}
+
+TEST(IPC, mux_fragments) {
+    // a tag takes a few bytes of the payload: the larger slot-sized messages are fragmented
+    std::size_t const sizes[] {1, ipc::data_length - 4, ipc::data_length - 3, ipc::data_length};
+    std::thread r1 {[&] {
+        ipc::mux r {"test-mux-fragments", ipc::receiver};
+        ASSERT_TRUE(r.subscribe("mux-a"));
+        for (auto size : sizes) {
+            ipc::mux::id_t id {};
+            auto buf = r.recv(ipc::invalid_value, &id);
+            ASSERT_EQ(buf.size(), size);
+            EXPECT_EQ(id, ipc::mux::id_of("mux-a"));
+            for (std::size_t i = 0; i < size; ++i) {
+                ASSERT_EQ(buf.get<unsigned char const *>()[i], static_cast<unsigned char>(i + size));
+            }
+        }
+    }};
+    ipc::mux s {"test-mux-fragments", ipc::sender};
+    ASSERT_TRUE(s.channel().wait_for_recv(1));
+    for (auto size : sizes) {
+        std::vector<unsigned char> data(size);
+        for (std::size_t i = 0; i < size; ++i) data[i] = static_cast<unsigned char>(i + size);
+        ASSERT_TRUE(s.send("mux-a", data.data(), size, ipc::invalid_value));
+    }
+    r1.join();
+}
+
+TEST(IPC, mux_collision) {
+    // find two names sharing an id
+    std::unordered_map<ipc::mux::id_t, std::string> seen;
+    std::string a, b;
+    for (int i = 0; a.empty(); ++i) {
+        auto name = "mux-" + std::to_string(i);
+        auto ret  = seen.emplace(ipc::mux::id_of(name.c_str()), name);
+        if (!ret.second) {
+            a = ret.first->second;
+            b = name;
+        }
+    }
+    ipc::shm::remove("__MUX__test-mux-collision");
+    ipc::mux s {"test-mux-collision", ipc::sender};
+    ipc::mux r {"test-mux-collision", ipc::receiver};
+    ASSERT_TRUE(r.subscribe(a.c_str()));
+    int n = 0;
+    EXPECT_TRUE (s.send(a.c_str(), &n, sizeof(n)));
+    // the second name is refused on both sides
+    EXPECT_FALSE(s.send(b.c_str(), &n, sizeof(n)));
+    EXPECT_FALSE(r.subscribe(b.c_str()));
+}
+
+TEST(IPC, mux_timeout) {
+    // steady traffic of another logical channel doesn't keep recv from timing out
+    std::atomic<bool> stop {false};
+    ipc::mux r {"test-mux-timeout", ipc::receiver};
+    ASSERT_TRUE(r.subscribe("mux-b"));
+    std::thread s {[&] {
+        ipc::mux s {"test-mux-timeout", ipc::sender};
+        for (int n = 0; !stop.load(std::memory_order_relaxed); ++n) {
+            s.send("mux-a", &n, sizeof(n), 100);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }};
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(r.recv(200).empty());
+    auto spent = std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::steady_clock::now() - start).count();
+    stop.store(true, std::memory_order_relaxed);
+    s.join();
+    EXPECT_LT(spent, 1000);
+}
+
+TEST(IPC, merge) {
+    constexpr int Count = 1000;
+    char const * names[] {"test-merge-0", "test-merge-1", "test-merge-2"};
+
+    ipc::merge_receiver r {names[0], names[1], names[2]};
+    ASSERT_EQ(r.size(), 3);
+
+    // every producer sends increasing keys with random gaps, then a final key
+    auto producer = [&](int k) {
+        ipc::route s {names[k], ipc::sender};
+        ASSERT_TRUE(s.wait_for_recv(1));
+        capo::random<> rdm {1, 100};
+        std::uint64_t key = 0;
+        for (int i = 0; i < Count; ++i) {
+            key += rdm();
+            ASSERT_TRUE(s.send(&key, sizeof(key), ipc::invalid_value));
+        }
+        key = (std::numeric_limits<std::uint64_t>::max)();
+        ASSERT_TRUE(s.send(&key, sizeof(key), ipc::invalid_value));
+    };
+    std::vector<std::thread> producers;
+    for (int k = 0; k < 3; ++k) producers.emplace_back(producer, k);
+
+    std::uint64_t last = 0;
+    int received = 0;
+    for (int done = 0; done < 3; ++received) {
+        std::size_t idx {};
+        // a finished channel would never have a message again
+        auto buf = r.recv((done == 0) ? static_cast<std::uint64_t>(ipc::invalid_value) : std::uint64_t(100), &idx);
+        ASSERT_EQ(buf.size(), sizeof(std::uint64_t));
+        auto key = ipc::merge_receiver::key_of(buf);
+        ASSERT_GE(key, last);
+        last = key;
+        if (key == (std::numeric_limits<std::uint64_t>::max)()) ++done;
+    }
+    for (auto & t : producers) t.join();
+    EXPECT_EQ(received, (Count + 1) * 3);
+    EXPECT_EQ(r.late(), 0u);
+}
+
+TEST(IPC, merge_late) {
+    ipc::merge_receiver r {"test-merge-late-0", "test-merge-late-1"};
+    ipc::route s0 {"test-merge-late-0", ipc::sender};
+    ipc::route s1 {"test-merge-late-1", ipc::sender};
+    std::uint64_t key = 5;
+    ASSERT_TRUE(s0.send(&key, sizeof(key)));
+    // channel 1 has nothing yet: yields 5 after the timeout
+    EXPECT_EQ(ipc::merge_receiver::key_of(r.recv(100)), 5u);
+    // 3 comes too late for the order, and is dropped
+    key = 3;
+    ASSERT_TRUE(s1.send(&key, sizeof(key)));
+    key = 7;
+    ASSERT_TRUE(s0.send(&key, sizeof(key)));
+    EXPECT_EQ(ipc::merge_receiver::key_of(r.recv(100)), 7u);
+    EXPECT_EQ(r.late(), 1u);
+}
+
+#if defined(IPC_OS_LINUX_)
+TEST(IPC, send_remote) {
+    constexpr int    Count = 20;
+    constexpr size_t Size  = 4 * 1024 * 1024;
+
+    auto reader = [&](int /*k*/) {
+        ipc::route r {"test-send-remote", ipc::receiver};
+        for (int i = 0; i < Count; ++i) {
+            auto buf = r.recv();
+            ASSERT_EQ(buf.size(), Size);
+            EXPECT_EQ(buf.get<int const *>()[0], i);
+            EXPECT_EQ(buf.get<int const *>()[Size / sizeof(int) - 1], i);
+        }
+    };
+    std::thread r1 {reader, 0};
+    std::thread r2 {reader, 1};
+    ipc::route s {"test-send-remote", ipc::sender};
+    ASSERT_TRUE(s.wait_for_recv(2));
+
+    std::vector<int> data(Size / sizeof(int));
+    for (int i = 0; i < Count; ++i) {
+        std::fill(data.begin(), data.end(), i);
+        // returns after both receivers have copied the data
+        ASSERT_TRUE(s.send_remote(data.data(), Size, 5000));
+    }
+    r1.join();
+    r2.join();
+}
+
+TEST(IPC, send_remote_disconnected) {
+    constexpr size_t Size = 1024 * 1024;
+
+    std::atomic<bool> connected {false};
+    std::thread r1 {[&] {
+        ipc::route r {"test-send-remote-dis", ipc::receiver};
+        auto buf = r.recv();
+        EXPECT_EQ(buf.size(), Size);
+    }};
+    std::thread r2 {[&] {
+        // never receives, leaves while the sender is waiting for it
+        ipc::route r {"test-send-remote-dis", ipc::receiver};
+        connected = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }};
+    ipc::route s {"test-send-remote-dis", ipc::sender};
+    ASSERT_TRUE(s.wait_for_recv(2));
+    while (!connected) std::this_thread::yield();
+
+    std::vector<char> data(Size, 'a');
+    EXPECT_TRUE(s.send_remote(data.data(), Size, 5000));
+    r1.join();
+    r2.join();
+}
+
+TEST(IPC, send_memfd) {
+    constexpr int    Count = 10;
+    constexpr size_t Size  = 16 * 1024 * 1024;
+
+    auto reader = [&](int /*k*/) {
+        ipc::route r {"test-send-memfd", ipc::receiver};
+        for (int i = 0; i < Count; ++i) {
+            auto buf = r.recv();
+            ASSERT_EQ(buf.size(), Size);
+            EXPECT_EQ(buf.get<int const *>()[0], i);
+            EXPECT_EQ(buf.get<int const *>()[Size / sizeof(int) - 1], i);
+        }
+    };
+    std::thread r1 {reader, 0};
+    std::thread r2 {reader, 1};
+    ipc::route s {"test-send-memfd", ipc::sender};
+    ASSERT_TRUE(s.wait_for_recv(2));
+
+    std::vector<int> data(Size / sizeof(int));
+    for (int i = 0; i < Count; ++i) {
+        std::fill(data.begin(), data.end(), i);
+        // the receivers map a sealed copy, so data could be reused right away
+        ASSERT_TRUE(s.send_memfd(data.data(), Size, 5000));
+    }
+    r1.join();
+    r2.join();
+}
+
+TEST(IPC, send_memfd_unsealed) {
+    constexpr size_t Size = 1024 * 1024;
+
+    int fd = static_cast<int>(::syscall(SYS_memfd_create, "test-memfd", MFD_CLOEXEC | MFD_ALLOW_SEALING));
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(::ftruncate(fd, Size), 0);
+    ipc::route s {"test-send-memfd-unsealed", ipc::sender};
+    ipc::route r {"test-send-memfd-unsealed", ipc::receiver};
+    // the sender could still change it under the mappings of the receivers
+    EXPECT_FALSE(s.send_memfd(fd, Size, 1000));
+    ASSERT_EQ(::fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE), 0);
+    // not as large as the message
+    EXPECT_FALSE(s.send_memfd(fd, Size * 2, 1000));
+    ::close(fd);
+}
+
+#endif // IPC_OS_LINUX_
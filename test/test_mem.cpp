@@ -3,6 +3,7 @@
 #include <thread>
 #include <atomic>
 #include <cstddef>
+#include <cstring>
 
 #include "capo/random.hpp"
 
@@ -215,4 +216,162 @@ TEST(Memory, pool_alloc) {
 //     test_performance<tc_alloc, alloc_Random, ThreadMax>::start();
 // }
 
+/**
+ * IPC-realistic allocator benchmarks:
+ * the recv thread allocates the buffers of incoming messages,
+ * and the worker threads which consume the messages free them.
+*/
+
+constexpr int IpcLoopCount = 131072;
+
+/// Most messages fit in one slot, some need reassembly, a few are large.
+std::vector<std::size_t> const & ipc_sizes() {
+    static std::vector<std::size_t> sizes = [] {
+        std::vector<std::size_t> ret;
+        capo::random<> pct  {0, 99};
+        capo::random<> smal {4, 64};
+        capo::random<> midd {65, 1024};
+        capo::random<> larg {1025, 8192};
+        for (int i = 0; i < IpcLoopCount; ++i) {
+            int k = pct();
+            ret.push_back(static_cast<std::size_t>((k < 70) ? smal() : ((k < 95) ? midd() : larg())));
+        }
+        return ret;
+    }();
+    return sizes;
+}
+
+/// A candidate configuration of the async_pool_alloc stack (see: libipc/memory/resource.h).
+template <std::size_t ChunkSize, std::size_t BaseSize, std::size_t LimitSize>
+using pool_stack_t = ipc::mem::variable_wrapper<ipc::mem::async_wrapper<
+    ipc::mem::detail::fixed_alloc<
+        ipc::mem::variable_alloc<ChunkSize>,
+        ipc::mem::fixed_expand_policy<BaseSize, LimitSize>>,
+    ipc::mem::default_recycler>>;
+
+using locked_fixed_t = ipc::mem::variable_wrapper<ipc::mem::sync_wrapper<
+    ipc::mem::detail::fixed_alloc<ipc::mem::scope_alloc<>, ipc::mem::fixed_expand_policy<>>>>;
+
+/**
+ * The threads are started & joined here, inside the lifetime of the allocator:
+ * the per-thread states of an allocator must not outlive it.
+*/
+
+/// alloc & free on the same thread
+template <typename AllocT>
+void benchmark_ipc_alloc(char const * message) {
+    auto const & sizes = ipc_sizes();
+    AllocT alc;
+    ipc_ut::test_stopwatch sw;
+    std::thread {[&] {
+        sw.start();
+        for (int n = 0; n < IpcLoopCount; ++n) {
+            std::size_t s = sizes[static_cast<std::size_t>(n)];
+            void *p = alc.alloc(s);
+            static_cast<ipc::byte_t *>(p)[0] = 0;
+            alc.free(p, s);
+        }
+    }}.join();
+    std::string msg = std::string{"ipc-same\t"} + message;
+    sw.print_elapsed(1, IpcLoopCount, msg.c_str());
+}
+
+/// alloc on the recv thread, free on WorkerN worker threads
+template <typename AllocT, int WorkerN>
+void benchmark_ipc_alloc(char const * message) {
+    auto const & sizes = ipc_sizes();
+    AllocT alc;
+    std::vector<std::atomic<void *>> slots(IpcLoopCount);
+    for (auto &p : slots) p.store(nullptr, std::memory_order_relaxed);
+
+    ipc_ut::test_stopwatch sw;
+    std::vector<std::thread> workers;
+    for (int k = 0; k < WorkerN; ++k) {
+        workers.emplace_back([&, k] {
+            for (int n = k; n < IpcLoopCount; n += WorkerN) {
+                void *p;
+                while ((p = slots[static_cast<std::size_t>(n)].load(std::memory_order_acquire)) == nullptr) {
+                    std::this_thread::yield();
+                }
+                alc.free(p, sizes[static_cast<std::size_t>(n)]);
+            }
+        });
+    }
+    std::thread {[&] {
+        sw.start();
+        for (int n = 0; n < IpcLoopCount; ++n) {
+            std::size_t s = sizes[static_cast<std::size_t>(n)];
+            void *p = alc.alloc(s);
+            static_cast<ipc::byte_t *>(p)[0] = 0;
+            slots[static_cast<std::size_t>(n)].store(p, std::memory_order_release);
+        }
+    }}.join();
+    for (auto &t : workers) t.join();
+    std::string msg = std::string{"ipc-handoff\t"} + message;
+    sw.print_elapsed(WorkerN, IpcLoopCount, msg.c_str());
+}
+
+template <typename AllocT>
+void benchmark_ipc_allocs(char const * message) {
+    benchmark_ipc_alloc<AllocT>   (message);
+    benchmark_ipc_alloc<AllocT, 1>(message);
+    benchmark_ipc_alloc<AllocT, 4>(message);
+}
+
 } // internal-linkage
+
+/**
+ * The benchmarks are disabled in the unit-test runs, run them by:
+ * test-ipc --gtest_also_run_disabled_tests --gtest_filter=Memory.DISABLED_bench_*
+*/
+
+TEST(Memory, DISABLED_bench_ipc_alloc_policies) {
+    benchmark_ipc_allocs<ipc::mem::static_alloc                                  >("static_alloc");
+    benchmark_ipc_allocs<ipc::mem::sync_wrapper<ipc::mem::scope_alloc<>>         >("sync_wrapper<scope_alloc>");
+    benchmark_ipc_allocs<locked_fixed_t                                          >("variable_wrapper<sync_wrapper<fixed_alloc>>");
+    benchmark_ipc_allocs<ipc::mem::sync_wrapper<ipc::mem::variable_alloc<>>      >("sync_wrapper<variable_alloc>");
+    benchmark_ipc_allocs<ipc::mem::async_pool_alloc                              >("async_pool_alloc");
+}
+
+TEST(Memory, DISABLED_bench_ipc_pool_stacks) {
+    benchmark_ipc_allocs<pool_stack_t<sizeof(void*) * 1024 * 256, sizeof(void*) * 1024, sizeof(void*) * 1024 * 256>>("pool_stack<2M chunk, 8K base>");
+    benchmark_ipc_allocs<pool_stack_t<sizeof(void*) * 1024 * 16 , sizeof(void*) * 1024, sizeof(void*) * 1024 * 16 >>("pool_stack<128K chunk, 8K base>");
+    benchmark_ipc_allocs<pool_stack_t<sizeof(void*) * 1024 * 256, sizeof(void*) * 64  , sizeof(void*) * 1024 * 256>>("pool_stack<2M chunk, 512 base>");
+}
+
+TEST(Memory, async_wrapper_lifetime) {
+    using stack_t = pool_stack_t<sizeof(void*) * 1024 * 16, sizeof(void*) * 64, sizeof(void*) * 1024 * 16>;
+    // every size class has its own proxy: the blocks must not overlap
+    {
+        stack_t alc;
+        auto p1 = static_cast<char *>(alc.alloc(16));
+        auto p2 = static_cast<char *>(alc.alloc(1000));
+        std::memset(p2, 0x5a, 1000);
+        std::memset(p1, 0xa5, 16);
+        EXPECT_EQ(static_cast<unsigned char>(p2[0]), 0x5a);
+        alc.free(p1, 16);
+        alc.free(p2, 1000);
+    }
+    // a thread exits after the wrapper it has used, a new wrapper may be at the same address
+    std::atomic<int> step {0};
+    std::thread t;
+    {
+        stack_t alc;
+        t = std::thread {[&] {
+            alc.free(alc.alloc(100), 100);
+            step = 1;
+            while (step != 2) std::this_thread::yield();
+        }};
+        while (step != 1) std::this_thread::yield();
+    }
+    {
+        stack_t alc;
+        for (int i = 0; i < 1000; ++i) {
+            void *p = alc.alloc(100);
+            std::memset(p, 0, 100);
+            alc.free(p, 100);
+        }
+    }
+    step = 2;
+    t.join();
+}
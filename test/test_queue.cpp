@@ -5,6 +5,7 @@
 #include <new>
 #include <vector>
 #include <unordered_map>
+#include <array>
 #include <climits>  // CHAR_BIT
 
 #include "libipc/prod_cons.h"
@@ -51,8 +52,8 @@ void push(Que & que, int p, int d) {
 }
 
 template <typename Que>
-msg_t pop(Que & que) {
-    msg_t msg;
+typename Que::value_t pop(Que & que) {
+    typename Que::value_t msg;
     while (!que.pop(msg)) {
         std::this_thread::yield();
     }
@@ -113,6 +114,104 @@ void test_sr(elems_t<Rp, Rc, Ts> && elems, int s_cnt, int r_cnt, char const * me
     sw.print_elapsed(s_cnt, r_cnt, LoopCount, message);
 }
 
+/**
+ * Microbenchmarks of the bare ring algorithms (prod_cons_impl),
+ * without waiters or the framing of ipc::route/ipc::channel.
+ * They are disabled in the unit-test runs, run them by:
+ * test-ipc --gtest_also_run_disabled_tests --gtest_filter=Queue.DISABLED_bench_*
+*/
+
+constexpr int BenchLoop = 100000;
+
+template <std::size_t N>
+struct payload_t : msg_t {
+    std::array<char, N - sizeof(msg_t)> pad_;
+
+    payload_t() = default;
+    payload_t(int p, int d) : msg_t(p, d) {}
+};
+
+template <ipc::relat Rp, ipc::relat Rc, ipc::trans Ts, std::size_t N>
+using bench_queue_t = ipc::queue<payload_t<N>, ipc::policy::choose<ipc::circ::elem_array, ipc::wr<Rp, Rc, Ts>>>;
+
+template <ipc::relat Rp, ipc::relat Rc, ipc::trans Ts, std::size_t N>
+using bench_elems_t = typename bench_queue_t<Rp, Rc, Ts, N>::elems_t;
+
+/// One thread pushes & pops in turn: the cost of an uncontended push + pop.
+template <ipc::relat Rp, ipc::relat Rc, ipc::trans Ts, std::size_t N>
+void bench_pair(char const * message) {
+    auto elems = std::make_unique<bench_elems_t<Rp, Rc, Ts, N>>();
+    bench_queue_t<Rp, Rc, Ts, N> que { elems.get() };
+    ASSERT_TRUE(que.connect());
+    payload_t<N> msg;
+    capo::stopwatch<> sw { true };
+    for (int i = 0; i < BenchLoop; ++i) {
+        ASSERT_TRUE(que.push([](void*) { return true; }, 0, i));
+        ASSERT_TRUE(que.pop(msg));
+    }
+    auto ts = sw.elapsed<std::chrono::nanoseconds>();
+    std::cout << "[bench] " << message << "/" << N << "B\tpush+pop\t"
+              << (double(ts) / BenchLoop) << " ns" << std::endl;
+}
+
+/// s_cnt producers & r_cnt consumers: the cost per message under contention.
+template <ipc::relat Rp, ipc::relat Rc, ipc::trans Ts, std::size_t N>
+void bench_sr(int s_cnt, int r_cnt, char const * message) {
+    auto elems = std::make_unique<bench_elems_t<Rp, Rc, Ts, N>>();
+    ipc_ut::sender().start(static_cast<std::size_t>(s_cnt));
+    ipc_ut::reader().start(static_cast<std::size_t>(r_cnt));
+    ipc_ut::test_stopwatch sw;
+
+    for (int k = 0; k < s_cnt; ++k) {
+        ipc_ut::sender() << [&elems, &sw, r_cnt, k] {
+            bench_queue_t<Rp, Rc, Ts, N> que { elems.get() };
+            while (que.conn_count() != static_cast<std::size_t>(r_cnt)) {
+                std::this_thread::yield();
+            }
+            sw.start();
+            for (int i = 0; i < BenchLoop; ++i) {
+                push(que, k, i);
+            }
+        };
+    }
+    for (int k = 0; k < r_cnt; ++k) {
+        ipc_ut::reader() << [&elems] {
+            bench_queue_t<Rp, Rc, Ts, N> que { elems.get() };
+            ASSERT_TRUE(que.connect());
+            while (pop(que).pid_ >= 0) ;
+            ASSERT_TRUE(que.disconnect());
+        };
+    }
+
+    ipc_ut::sender().wait_for_done();
+    quitter<Ts>::emit(bench_queue_t<Rp, Rc, Ts, N> { elems.get() }, r_cnt);
+    ipc_ut::reader().wait_for_done();
+    std::cout << "[bench] " << message << "/" << N << "B\t";
+    sw.print_elapsed(s_cnt, r_cnt, BenchLoop, "push/pop");
+}
+
+template <std::size_t N>
+void bench_all_pairs() {
+    bench_pair<ipc::relat::single, ipc::relat::single, ipc::trans::unicast  , N>("ssu");
+    bench_pair<ipc::relat::single, ipc::relat::multi , ipc::trans::unicast  , N>("smu");
+    bench_pair<ipc::relat::multi , ipc::relat::multi , ipc::trans::unicast  , N>("mmu");
+    bench_pair<ipc::relat::single, ipc::relat::multi , ipc::trans::broadcast, N>("smb");
+    bench_pair<ipc::relat::multi , ipc::relat::multi , ipc::trans::broadcast, N>("mmb");
+}
+
+template <std::size_t N>
+void bench_all_sr() {
+    bench_sr<ipc::relat::single, ipc::relat::single, ipc::trans::unicast, N>(1, 1, "ssu");
+    for (int r : {1, 2, 4}) {
+        bench_sr<ipc::relat::single, ipc::relat::multi, ipc::trans::unicast  , N>(1, r, "smu");
+        bench_sr<ipc::relat::single, ipc::relat::multi, ipc::trans::broadcast, N>(1, r, "smb");
+    }
+    for (int s : {1, 2, 4}) for (int r : {1, 2, 4}) {
+        bench_sr<ipc::relat::multi, ipc::relat::multi, ipc::trans::unicast  , N>(s, r, "mmu");
+        bench_sr<ipc::relat::multi, ipc::relat::multi, ipc::trans::broadcast, N>(s, r, "mmb");
+    }
+}
+
 } // internal-linkage
 
 TEST(Queue, check_size) {
@@ -302,3 +401,15 @@ TEST(Queue, prod_cons_NvN_broadcast) {
         test_sr(elems_t<ipc::relat::multi , ipc::relat::multi , ipc::trans::broadcast>{}, i, i, "mmb");
     }
 }
+
+TEST(Queue, DISABLED_bench_uncontended) {
+    bench_all_pairs<8  >();
+    bench_all_pairs<64 >();
+    bench_all_pairs<256>();
+}
+
+TEST(Queue, DISABLED_bench_contended) {
+    bench_all_sr<8  >();
+    bench_all_sr<64 >();
+    bench_all_sr<256>();
+}
@@ -1,18 +1,33 @@
 
 #include <thread>
+#include <atomic>
 #include <iostream>
 #include <mutex>
 #include <chrono>
 #include <deque>
 #include <array>
+#include <vector>
 #include <cstdio>
 
 #include "test.h"
 
+#include "libipc/rw_lock.h"
+#include "libipc/shm.h"
+#include "libipc/ipc.h"
+#include "libipc/barrier.h"
+#include "libipc/latch.h"
+#include "libipc/sync/participants.h"
+
 #include "libipc/platform/detail.h"
+#if !defined(IPC_OS_WINDOWS_)
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 #if defined(IPC_OS_LINUX_)
 #include <pthread.h>
 #include <time.h>
+#include <sched.h>
 
 TEST(PThread, Robust) {
     pthread_mutexattr_t ma;
@@ -175,6 +190,39 @@ TEST(Sync, Condition) {
     for (auto &t : test_conds) t.join();
 }
 
+TEST(Sync, ConditionBroadcastHandoff) {
+    // a broadcast wakes all the waiters, timed ones too, & they own the mutex one by one
+    constexpr int N = 16;
+    ipc::sync::mutex     lock {"test-cond-handoff-mtx"};
+    ipc::sync::condition cond {"test-cond-handoff-cv"};
+    std::atomic<int> waiting {0}, woken {0}, inside {0}, overlap {0};
+    bool go = false;
+
+    std::vector<std::thread> waiters;
+    for (int k = 0; k < N; ++k) {
+        waiters.emplace_back([&, k] {
+            ipc::sync::mutex     lock {"test-cond-handoff-mtx"};
+            ipc::sync::condition cond {"test-cond-handoff-cv"};
+            std::lock_guard<ipc::sync::mutex> guard {lock};
+            waiting.fetch_add(1);
+            while (!go) cond.wait(lock, (k % 2) ? 10000 : static_cast<std::uint64_t>(ipc::invalid_value));
+            if (inside.fetch_add(1) != 0) overlap.fetch_add(1);
+            std::this_thread::yield();
+            inside.fetch_sub(1);
+            woken.fetch_add(1);
+        });
+    }
+    while (waiting.load() != N) std::this_thread::yield();
+    {
+        std::lock_guard<ipc::sync::mutex> guard {lock};
+        go = true;
+        ASSERT_TRUE(cond.broadcast(lock));
+    }
+    for (auto &t : waiters) t.join();
+    EXPECT_EQ(woken.load(), N);
+    EXPECT_EQ(overlap.load(), 0);
+}
+
 /**
  * https://stackoverflow.com/questions/51730660/is-this-a-bug-in-glibc-pthread
 */
@@ -205,4 +253,608 @@ TEST(Sync, ConditionRobust) {
     ASSERT_TRUE(lock.unlock());
     printf("XXXXXXXXXXXXXXXXXXXXXXXXXXXXXX 6\n");
     unlock.join();
-}
\ No newline at end of file
+}
+
+#if defined(IPC_OS_LINUX_)
+namespace {
+
+bool set_fifo_priority(int prio, int cpu) {
+    cpu_set_t cs;
+    CPU_ZERO(&cs);
+    CPU_SET(cpu, &cs);
+    if (::pthread_setaffinity_np(::pthread_self(), sizeof(cs), &cs) != 0) {
+        return false;
+    }
+    sched_param sp {};
+    sp.sched_priority = prio;
+    return ::pthread_setschedparam(::pthread_self(), SCHED_FIFO, &sp) == 0;
+}
+
+void busy_for(std::chrono::milliseconds tm) {
+    auto tp = std::chrono::steady_clock::now() + tm;
+    while (std::chrono::steady_clock::now() < tp) ;
+}
+
+} // internal-linkage
+
+/**
+ * Low/medium/high SCHED_FIFO threads pinned to the same cpu.
+ * Without priority inheritance the medium one keeps the owner (low) off the cpu,
+ * and the high one has to wait for the whole hog period.
+*/
+TEST(Sync, MutexPriorityInheritance) {
+    constexpr int  Rounds   = 5;
+    constexpr auto cs_time  = std::chrono::milliseconds(5);
+    constexpr auto hog_time = std::chrono::milliseconds(50);
+
+    int cpu = ::sched_getcpu();
+    bool rt_enabled = false;
+    std::thread{[&rt_enabled, cpu] { rt_enabled = set_fifo_priority(1, cpu); }}.join();
+    if (!rt_enabled) {
+        GTEST_SKIP() << "SCHED_FIFO is not permitted here.";
+    }
+
+    ipc::sync::mutex lock {"test-mutex-pi", true};
+    ASSERT_TRUE(lock.valid());
+
+    std::chrono::steady_clock::duration worst {};
+    for (int i = 0; i < Rounds; ++i) {
+        std::atomic<bool> held {false};
+        std::atomic<bool> no_rt {false}, failed {false};
+        std::chrono::steady_clock::duration latency {};
+
+        std::thread low {[&] {
+            if (!set_fifo_priority(10, cpu)) no_rt = true;
+            if (!lock.lock()) {
+                failed = true;
+                held.store(true, std::memory_order_release);
+                return;
+            }
+            held.store(true, std::memory_order_release);
+            // give the others a chance to start
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            busy_for(cs_time);
+            if (!lock.unlock()) failed = true;
+        }};
+        while (!held.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+        std::thread high {[&] {
+            if (!set_fifo_priority(30, cpu)) no_rt = true;
+            auto tp = std::chrono::steady_clock::now();
+            if (!lock.lock()) {
+                failed = true;
+                return;
+            }
+            latency = std::chrono::steady_clock::now() - tp;
+            if (!lock.unlock()) failed = true;
+        }};
+        std::thread medium {[&] {
+            if (!set_fifo_priority(20, cpu)) no_rt = true;
+            busy_for(hog_time);
+        }};
+        low.join();
+        high.join();
+        medium.join();
+        ASSERT_FALSE(failed) << "lock/unlock failed in round " << i;
+        if (no_rt) {
+            GTEST_SKIP() << "SCHED_FIFO could not be set on every thread.";
+        }
+        worst = (std::max)(worst, latency);
+    }
+    auto worst_us = std::chrono::duration_cast<std::chrono::microseconds>(worst).count();
+    std::cout << "[" << Rounds << "] mutex-pi worst-case lock latency\t" << worst_us << " us" << std::endl;
+    EXPECT_LT(worst, std::chrono::steady_clock::duration{hog_time});
+}
+#endif // IPC_OS_LINUX_
+
+/**
+ * Benchmarks of the synchronization primitives.
+ * The numbers are the baseline for the costs of ipc::detail::waiter.
+ * They are disabled in the unit-test runs, run them by:
+ * test-ipc --gtest_also_run_disabled_tests --gtest_filter=Sync.DISABLED_bench_*
+*/
+
+namespace {
+
+constexpr int SyncBenchLoop = 100000;
+
+template <typename Lock>
+void bench_lock(Lock &lc, char const *message) {
+    ipc_ut::test_stopwatch sw;
+    sw.start();
+    for (int i = 0; i < SyncBenchLoop; ++i) {
+        lc.lock();
+        lc.unlock();
+    }
+    sw.print_elapsed(1, SyncBenchLoop, message);
+}
+
+/// Two threads take turns through a pair of semaphores, the cost is per handoff.
+void bench_sem_handoff(char const *message) {
+    ipc::sync::semaphore ping {"bench-sem-ping"}, pong {"bench-sem-pong"};
+    std::thread peer {[] {
+        ipc::sync::semaphore ping {"bench-sem-ping"}, pong {"bench-sem-pong"};
+        for (int i = 0; i < SyncBenchLoop; ++i) {
+            bool ok = ping.wait(1000) && pong.post();
+            EXPECT_TRUE(ok);
+            if (!ok) return;
+        }
+    }};
+    ipc_ut::test_stopwatch sw;
+    sw.start();
+    for (int i = 0; i < SyncBenchLoop; ++i) {
+        bool ok = ping.post() && pong.wait(1000);
+        EXPECT_TRUE(ok);
+        if (!ok) break;
+    }
+    sw.print_elapsed(1, SyncBenchLoop * 2, message);
+    peer.join();
+}
+
+struct turn_t {
+    std::atomic<int> turn {0};
+};
+
+/// Two threads take turns through mutex + condition, the cost is per handoff.
+template <typename Turn>
+void cond_handoff(Turn *tn, int me, int loops) {
+    ipc::sync::mutex     lock {"bench-cond-handoff-mtx"};
+    ipc::sync::condition cond {"bench-cond-handoff-cv"};
+    for (int i = 0; i < loops; ++i) {
+        std::lock_guard<ipc::sync::mutex> guard {lock};
+        while (tn->turn.load(std::memory_order_relaxed) != me) {
+            cond.wait(lock);
+        }
+        tn->turn.store(1 - me, std::memory_order_relaxed);
+        cond.notify(lock);
+    }
+}
+
+void bench_cond_handoff(char const *message) {
+    turn_t tn;
+    std::thread peer {[&tn] { cond_handoff(&tn, 1, SyncBenchLoop); }};
+    ipc_ut::test_stopwatch sw;
+    sw.start();
+    cond_handoff(&tn, 0, SyncBenchLoop);
+    peer.join();
+    sw.print_elapsed(1, SyncBenchLoop * 2, message);
+}
+
+/// N sleeping waiters: the cost of waking one of them (notify) vs. all of them (broadcast).
+void bench_cond_wake(int n, bool all, int rounds) {
+    ipc::sync::mutex     lock {"bench-cond-wake-mtx"};
+    ipc::sync::condition cond {"bench-cond-wake-cv"};
+    std::atomic<int> waiting {0}, woken {0};
+    int tokens = 0;
+    bool quit = false;
+
+    std::vector<std::thread> waiters;
+    for (int k = 0; k < n; ++k) {
+        waiters.emplace_back([&] {
+            ipc::sync::mutex     lock {"bench-cond-wake-mtx"};
+            ipc::sync::condition cond {"bench-cond-wake-cv"};
+            std::lock_guard<ipc::sync::mutex> guard {lock};
+            for (;;) {
+                waiting.fetch_add(1, std::memory_order_relaxed);
+                while ((tokens == 0) && !quit) cond.wait(lock);
+                waiting.fetch_sub(1, std::memory_order_relaxed);
+                if (quit) return;
+                --tokens;
+                woken.fetch_add(1, std::memory_order_release);
+            }
+        });
+    }
+    ipc_ut::test_stopwatch sw;
+    for (int r = 0; r < rounds; ++r) {
+        while (waiting.load(std::memory_order_relaxed) != n) std::this_thread::yield();
+        sw.start();
+        {
+            std::lock_guard<ipc::sync::mutex> guard {lock};
+            if (all) {
+                tokens = n;
+                cond.broadcast(lock);
+            } else {
+                for (int k = 0; k < n; ++k) {
+                    tokens += 1;
+                    cond.notify(lock);
+                }
+            }
+        }
+        while (woken.load(std::memory_order_acquire) != n * (r + 1)) std::this_thread::yield();
+    }
+    {
+        std::lock_guard<ipc::sync::mutex> guard {lock};
+        quit = true;
+        cond.broadcast(lock);
+    }
+    for (auto &t : waiters) t.join();
+    sw.print_elapsed(n, rounds, all ? "condition broadcast (all woken)" : "condition notify x N (all woken)");
+}
+
+/// The overshoot of a timed wait which always times out.
+template <typename F>
+void bench_timed_wait(std::uint64_t tm, int loops, char const *message, F &&wait) {
+    ipc_ut::test_stopwatch sw;
+    sw.start();
+    for (int i = 0; i < loops; ++i) {
+        EXPECT_FALSE(wait(tm));
+    }
+    auto ns = sw.sw_.elapsed<std::chrono::nanoseconds>() - static_cast<std::int64_t>(tm * 1000000 * loops);
+    std::cout << "[" << tm << " ms, \t" << loops << "] " << message << "\t"
+              << (double(ns) / double(loops)) << " ns overshoot" << std::endl;
+}
+
+} // internal-linkage
+
+TEST(Sync, DISABLED_bench_uncontended) {
+    ipc::sync::mutex mtx {"bench-mutex"};
+    bench_lock(mtx, "ipc::sync::mutex lock/unlock");
+    ipc::spin_lock sl;
+    bench_lock(sl, "ipc::spin_lock lock/unlock");
+    ipc::rw_lock rw;
+    bench_lock(rw, "ipc::rw_lock lock/unlock");
+    struct shared_t {
+        ipc::rw_lock &rw_;
+        void lock() noexcept { rw_.lock_shared(); }
+        void unlock() noexcept { rw_.unlock_shared(); }
+    } sh {rw};
+    bench_lock(sh, "ipc::rw_lock lock_shared/unlock_shared");
+    ipc::sync::semaphore sem {"bench-sem"};
+    ipc_ut::test_stopwatch sw;
+    sw.start();
+    for (int i = 0; i < SyncBenchLoop; ++i) {
+        sem.post();
+        sem.wait();
+    }
+    sw.print_elapsed(1, SyncBenchLoop, "ipc::sync::semaphore post/wait");
+#if defined(IPC_OS_LINUX_)
+    pthread_mutexattr_t ma;
+    pthread_mutexattr_init(&ma);
+    pthread_mutexattr_setpshared(&ma, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&ma, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_t pm;
+    pthread_mutex_init(&pm, &ma);
+    struct native_t {
+        pthread_mutex_t *pm_;
+        void lock() noexcept { pthread_mutex_lock(pm_); }
+        void unlock() noexcept { pthread_mutex_unlock(pm_); }
+    } pl {&pm};
+    bench_lock(pl, "pthread robust pshared mutex lock/unlock");
+    pthread_mutex_destroy(&pm);
+    pthread_mutexattr_destroy(&ma);
+#endif
+}
+
+TEST(Sync, DISABLED_bench_handoff) {
+    bench_sem_handoff("ipc::sync::semaphore handoff");
+    bench_cond_handoff("ipc::sync::condition handoff");
+}
+
+TEST(Sync, DISABLED_bench_wake_one_all) {
+    for (int n : {1, 4, 16}) {
+        bench_cond_wake(n, false, 200);
+        bench_cond_wake(n, true , 200);
+    }
+}
+
+TEST(Sync, DISABLED_bench_timed_wait) {
+    ipc::sync::semaphore sem {"bench-sem-timed"};
+    bench_timed_wait(0, 10000, "ipc::sync::semaphore wait(0)", [&sem](std::uint64_t tm) {
+        return sem.wait(tm);
+    });
+    bench_timed_wait(1, 100, "ipc::sync::semaphore wait(tm)", [&sem](std::uint64_t tm) {
+        return sem.wait(tm);
+    });
+    ipc::sync::mutex     lock {"bench-mutex-timed"};
+    ipc::sync::condition cond {"bench-cond-timed"};
+    std::lock_guard<ipc::sync::mutex> guard {lock};
+    bench_timed_wait(0, 10000, "ipc::sync::condition wait(0)", [&](std::uint64_t tm) {
+        return cond.wait(lock, tm);
+    });
+    bench_timed_wait(1, 100, "ipc::sync::condition wait(tm)", [&](std::uint64_t tm) {
+        return cond.wait(lock, tm);
+    });
+}
+
+#if !defined(IPC_OS_WINDOWS_)
+namespace {
+
+/// Two processes take turns through mutex + condition, the cost is per handoff.
+void bench_cond_handoff_cross_process(char const *message) {
+    ipc::shm::handle shm {"bench-cond-handoff-turn", sizeof(turn_t)};
+    ASSERT_TRUE(shm.valid());
+    auto tn = static_cast<turn_t *>(shm.get());
+    tn->turn.store(0);
+    pid_t pid = ::fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+        cond_handoff(tn, 1, SyncBenchLoop);
+        ::_exit(0);
+    }
+    ipc_ut::test_stopwatch sw;
+    sw.start();
+    cond_handoff(tn, 0, SyncBenchLoop);
+    int status = 0;
+    ASSERT_EQ(::waitpid(pid, &status, 0), pid);
+    sw.print_elapsed(1, SyncBenchLoop * 2, message);
+    EXPECT_TRUE(WIFEXITED(status) && (WEXITSTATUS(status) == 0));
+}
+
+} // internal-linkage
+
+TEST(Sync, DISABLED_bench_handoff_cross_process) {
+    {
+        ipc::sync::semaphore ping {"bench-sem-ping"}, pong {"bench-sem-pong"};
+        pid_t pid = ::fork();
+        ASSERT_GE(pid, 0);
+        if (pid == 0) {
+            for (int i = 0; i < SyncBenchLoop; ++i) {
+                if (!ping.wait() || !pong.post()) ::_exit(1);
+            }
+            ::_exit(0);
+        }
+        ipc_ut::test_stopwatch sw;
+        sw.start();
+        for (int i = 0; i < SyncBenchLoop; ++i) {
+            ASSERT_TRUE(ping.post());
+            ASSERT_TRUE(pong.wait());
+        }
+        sw.print_elapsed(1, SyncBenchLoop * 2, "ipc::sync::semaphore handoff (cross-process)");
+        int status = 0;
+        ASSERT_EQ(::waitpid(pid, &status, 0), pid);
+        EXPECT_TRUE(WIFEXITED(status) && (WEXITSTATUS(status) == 0));
+    }
+    bench_cond_handoff_cross_process("ipc::sync::condition handoff (cross-process)");
+}
+#endif // !IPC_OS_WINDOWS_
+
+#if defined(IPC_OS_LINUX_)
+TEST(Sync, Backend) {
+    auto def = ipc::sync::current_backend();
+    EXPECT_FALSE(ipc::sync::use_backend(ipc::sync::backend::win32));
+    {
+        ipc::sync::mutex lock {"test-backend-mtx"};
+        ASSERT_TRUE(lock.valid());
+        // not switched while some objects are opened
+        EXPECT_FALSE(ipc::sync::use_backend((def == ipc::sync::backend::futex) ? ipc::sync::backend::pthread
+                                                                               : ipc::sync::backend::futex));
+        EXPECT_TRUE (ipc::sync::use_backend(def));
+    }
+    for (auto b : {ipc::sync::backend::futex, ipc::sync::backend::pthread}) {
+        ASSERT_TRUE(ipc::sync::use_backend(b));
+        EXPECT_EQ(ipc::sync::current_backend(), b);
+        ipc::sync::mutex     lock {"test-backend-mtx"};
+        ipc::sync::condition cond {"test-backend-cv"};
+        ASSERT_TRUE(lock.valid());
+        ASSERT_TRUE(cond.valid());
+        int val = 0;
+        std::thread peer {[&val] {
+            ipc::sync::mutex     lock {"test-backend-mtx"};
+            ipc::sync::condition cond {"test-backend-cv"};
+            std::lock_guard<ipc::sync::mutex> guard {lock};
+            while (val != 1) cond.wait(lock);
+            val = 2;
+            cond.notify(lock);
+        }};
+        {
+            std::lock_guard<ipc::sync::mutex> guard {lock};
+            val = 1;
+            cond.notify(lock);
+            while (val != 2) cond.wait(lock);
+            // the timed wait goes with the clock of the backend
+            EXPECT_FALSE(cond.wait(lock, 10));
+        }
+        peer.join();
+        ASSERT_TRUE (lock.try_lock());
+        EXPECT_TRUE (lock.unlock());
+    }
+    {
+        // an object opened with the other backend fails, instead of never meeting this one
+        ipc::sync::semaphore locked {"test-backend-sem"};
+        pid_t pid = ::fork();
+        ASSERT_GE(pid, 0);
+        if (pid == 0) {
+            if (!ipc::sync::use_backend(ipc::sync::backend::futex) || !locked.wait(1000)) ::_exit(1);
+            ipc::sync::mutex fx {"test-backend-mtx"};
+            ::_exit(fx.valid() ? 2 : 0);
+        }
+        ASSERT_TRUE(ipc::sync::use_backend(ipc::sync::backend::pthread));
+        ipc::sync::mutex px {"test-backend-mtx"};
+        ASSERT_TRUE(px.lock());
+        ASSERT_TRUE(locked.post());
+        int status = 0;
+        ASSERT_EQ(::waitpid(pid, &status, 0), pid);
+        EXPECT_TRUE(WIFEXITED(status) && (WEXITSTATUS(status) == 0));
+        EXPECT_TRUE(px.unlock());
+    }
+    {
+        // so does connecting to a channel, the waiters of which are opened with the other backend
+        ipc::sync::semaphore connected {"test-backend-sem"};
+        pid_t pid = ::fork();
+        ASSERT_GE(pid, 0);
+        if (pid == 0) {
+            if (!ipc::sync::use_backend(ipc::sync::backend::futex) || !connected.wait(1000)) ::_exit(1);
+            ipc::route s;
+            ::_exit(s.connect("test-backend-chan", ipc::sender) ? 2 : 0);
+        }
+        ASSERT_TRUE(ipc::sync::use_backend(ipc::sync::backend::pthread));
+        ipc::route r {"test-backend-chan", ipc::receiver};
+        ASSERT_TRUE(r.valid());
+        ASSERT_TRUE(connected.post());
+        int status = 0;
+        ASSERT_EQ(::waitpid(pid, &status, 0), pid);
+        EXPECT_TRUE(WIFEXITED(status) && (WEXITSTATUS(status) == 0));
+    }
+    ASSERT_TRUE(ipc::sync::use_backend(def));
+}
+
+/**
+ * The futex backend against the pthread one, to pick the faster for a deployment
+ * (then by LIBIPC_SYNC_BACKEND, or -DLIBIPC_SYNC_BACKEND when building).
+*/
+TEST(Sync, DISABLED_bench_backends) {
+    auto def = ipc::sync::current_backend();
+    for (auto b : {ipc::sync::backend::futex, ipc::sync::backend::pthread}) {
+        ASSERT_TRUE(ipc::sync::use_backend(b));
+        std::string name = (b == ipc::sync::backend::futex) ? "futex" : "pthread";
+        std::cout << "--- ipc::sync backend: " << name << " ---" << std::endl;
+        {
+            ipc::sync::mutex mtx {"bench-backend-mutex"};
+            bench_lock(mtx, (name + " mutex lock/unlock").c_str());
+        }
+        bench_cond_handoff((name + " condition handoff").c_str());
+        bench_cond_handoff_cross_process((name + " condition handoff (cross-process)").c_str());
+        bench_cond_wake(4, false, 200);
+        bench_cond_wake(4, true , 200);
+    }
+    ASSERT_TRUE(ipc::sync::use_backend(def));
+}
+#endif // IPC_OS_LINUX_
+
+TEST(Sync, Barrier) {
+    constexpr int N = 4, Rounds = 1000;
+    std::atomic<int> phase[Rounds] {};
+    std::vector<std::thread> ts;
+    for (int k = 0; k < N; ++k) {
+        ts.emplace_back([&] {
+            ipc::sync::barrier bar {"test-barrier", N};
+            ASSERT_TRUE(bar.valid());
+            for (int r = 0; r < Rounds; ++r) {
+                phase[r].fetch_add(1);
+                ASSERT_TRUE(bar.arrive_and_wait());
+                // nobody goes on before all have arrived
+                EXPECT_EQ(phase[r].load(), N);
+            }
+        });
+    }
+    for (auto &t : ts) t.join();
+
+    // a different count is refused while it is opened
+    ipc::sync::barrier b1 {"test-barrier-count", 2};
+    ipc::sync::barrier b2 {"test-barrier-count", 3};
+    EXPECT_TRUE (b1.valid());
+    EXPECT_FALSE(b2.valid());
+    // giving up breaks it
+    EXPECT_FALSE(b1.arrive_and_wait(10));
+    EXPECT_TRUE (b1.broken());
+    EXPECT_FALSE(b1.arrive_and_wait());
+}
+
+TEST(Sync, Latch) {
+    constexpr int N = 8;
+    std::atomic<int> counted {0};
+    std::vector<std::thread> ts;
+    for (int k = 0; k < N; ++k) {
+        ts.emplace_back([&] {
+            ipc::sync::latch l {"test-latch", N};
+            ASSERT_TRUE(l.valid());
+            counted.fetch_add(1);
+            ASSERT_TRUE(l.arrive_and_wait());
+            EXPECT_EQ(counted.load(), N);
+        });
+    }
+    ipc::sync::latch l {"test-latch", N};
+    ASSERT_TRUE(l.wait());
+    EXPECT_TRUE(l.try_wait());
+    for (auto &t : ts) t.join();
+    // counting down an opened latch fails
+    EXPECT_FALSE(l.count_down());
+}
+
+#if !defined(IPC_OS_WINDOWS_)
+namespace {
+
+void clear_robust_segments() {
+    for (char const *name : {"__BARRIER__test-barrier-robust",
+                             "__LATCH__test-latch-robust",
+                             "__LATCH__test-latch-waiter",
+                             "__LATCH__test-latch-reclaim"}) {
+        ipc::shm::remove(name);
+    }
+}
+
+} // namespace
+
+TEST(Sync, BarrierLatchRobust) {
+    clear_robust_segments();
+    // a participant dies before its part: the others don't wait forever
+    {
+        ipc::sync::barrier bar {"test-barrier-robust", 2};
+        pid_t pid = ::fork();
+        ASSERT_GE(pid, 0);
+        if (pid == 0) {
+            ipc::sync::barrier bar {"test-barrier-robust"};
+            ::_exit(bar.valid() ? 0 : 1);
+        }
+        ASSERT_EQ(::waitpid(pid, nullptr, 0), pid);
+        EXPECT_FALSE(bar.arrive_and_wait(5000));
+        EXPECT_TRUE (bar.broken());
+    }
+    {
+        ipc::sync::latch l {"test-latch-robust", 2};
+        pid_t pid = ::fork();
+        ASSERT_GE(pid, 0);
+        if (pid == 0) {
+            ipc::sync::latch l {"test-latch-robust"};
+            ::_exit(l.valid() ? 0 : 1);
+        }
+        ASSERT_EQ(::waitpid(pid, nullptr, 0), pid);
+        EXPECT_FALSE(l.arrive_and_wait(1, 5000));
+        EXPECT_TRUE (l.broken());
+    }
+    // one only waiting dies: it owes nothing
+    {
+        ipc::sync::latch l {"test-latch-waiter", 2};
+        pid_t pid = ::fork();
+        ASSERT_GE(pid, 0);
+        if (pid == 0) {
+            ipc::sync::latch l {"test-latch-waiter", 0, 0};
+            ::_exit(l.valid() ? 0 : 1);
+        }
+        ASSERT_EQ(::waitpid(pid, nullptr, 0), pid);
+        std::thread t {[] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(300));
+            ipc::sync::latch l {"test-latch-waiter"};
+            EXPECT_TRUE(l.count_down());
+        }};
+        EXPECT_TRUE (l.arrive_and_wait(1, 5000));
+        EXPECT_FALSE(l.broken());
+        t.join();
+    }
+    // the slots of the dead ones are taken over
+    {
+        ipc::sync::latch l {"test-latch-reclaim", 1};
+        constexpr int N = ipc::detail::sync::participants::max_count;
+        for (int i = 0; i < N; ++i) {
+            pid_t pid = ::fork();
+            ASSERT_GE(pid, 0);
+            if (pid == 0) {
+                ipc::sync::latch l {"test-latch-reclaim", 0, 0};
+                ::_exit(l.valid() ? 0 : 1);
+            }
+            int status = 0;
+            ASSERT_EQ(::waitpid(pid, &status, 0), pid);
+            EXPECT_TRUE(WIFEXITED(status) && (WEXITSTATUS(status) == 0));
+        }
+        ipc::sync::latch l2 {"test-latch-reclaim"};
+        ASSERT_TRUE (l2.valid());
+        EXPECT_TRUE (l2.arrive_and_wait(1, 5000));
+        EXPECT_FALSE(l2.broken());
+    }
+    // the ones left behind by the dead start over
+    {
+        ipc::sync::barrier bar {"test-barrier-robust", 1};
+        ASSERT_TRUE (bar.valid());
+        EXPECT_FALSE(bar.broken());
+        EXPECT_TRUE (bar.arrive_and_wait(5000));
+    }
+    {
+        ipc::sync::latch l {"test-latch-robust", 1};
+        ASSERT_TRUE (l.valid());
+        EXPECT_FALSE(l.broken());
+        EXPECT_TRUE (l.arrive_and_wait(1, 5000));
+    }
+    clear_robust_segments();
+}
+#endif // !IPC_OS_WINDOWS_
@@ -0,0 +1,143 @@
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+#include "libipc/task_pool.h"
+
+#include "test.h"
+
+#include "libipc/platform/detail.h"
+#if !defined(IPC_OS_WINDOWS_)
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+TEST(TaskPool, own_deque) {
+    ipc::task_pool w {"test-task-pool-own", 16};
+    ASSERT_TRUE(w.valid());
+    ipc::task_pool::task_t t {};
+    EXPECT_FALSE(w.pop(t));
+    for (ipc::task_pool::task_t i = 0; i < 16; ++i) {
+        ASSERT_TRUE(w.push(i));
+    }
+    EXPECT_FALSE(w.push(16));
+
+    // a thief takes the oldest, the owner the latest
+    ipc::task_pool thief {"test-task-pool-own", 16};
+    ASSERT_TRUE(thief.valid());
+    EXPECT_NE(thief.index(), w.index());
+    ASSERT_TRUE(thief.steal(t));
+    EXPECT_EQ(t, 0);
+    ASSERT_TRUE(w.pop(t));
+    EXPECT_EQ(t, 15);
+    for (ipc::task_pool::task_t i = 14; i > 0; --i) {
+        ASSERT_TRUE(w.pop(t));
+        EXPECT_EQ(t, i);
+    }
+    EXPECT_FALSE(w.pop(t));
+    EXPECT_FALSE(thief.steal(t));
+    EXPECT_FALSE(thief.take(t, 10));
+}
+
+TEST(TaskPool, stealing) {
+    constexpr int Workers = 4;
+    constexpr int Tasks   = 100000;
+
+    std::vector<std::atomic<int>> done(Tasks);
+    std::atomic<int> count {0};
+    std::atomic<int> stolen {0};
+
+    // all tasks are pushed by worker 0, the others have to steal them
+    auto worker = [&](int k) {
+        ipc::task_pool w {"test-task-pool-stealing"};
+        EXPECT_TRUE(w.valid());
+        if (!w.valid()) {
+            count.store(Tasks, std::memory_order_release); // let the others stop
+            return;
+        }
+        int pushed = 0;
+        while (count.load(std::memory_order_acquire) < Tasks) {
+            if (k == 0) {
+                while ((pushed < Tasks) && w.push(static_cast<ipc::task_pool::task_t>(pushed))) ++pushed;
+            }
+            ipc::task_pool::task_t t {};
+            if (!w.take(t, 10)) continue;
+            if (k != 0) stolen.fetch_add(1, std::memory_order_relaxed);
+            done[static_cast<std::size_t>(t)].fetch_add(1, std::memory_order_relaxed);
+            count.fetch_add(1, std::memory_order_release);
+        }
+    };
+    std::vector<std::thread> workers;
+    for (int k = 0; k < Workers; ++k) workers.emplace_back(worker, k);
+    for (auto & t : workers) t.join();
+
+    for (int i = 0; i < Tasks; ++i) {
+        ASSERT_EQ(done[i].load(), 1) << i;
+    }
+    std::printf("TaskPool.stealing: %d of %d tasks stolen\n", stolen.load(), Tasks);
+}
+
+TEST(TaskPool, take_timeout) {
+    ipc::task_pool w {"test-task-pool-timeout", 16};
+    ASSERT_TRUE(w.valid());
+    // pushes on another deque wake the parked worker up, but don't extend its timeout
+    std::atomic<bool> stop {false};
+    std::thread other {[&] {
+        ipc::task_pool o {"test-task-pool-timeout", 16};
+        for (ipc::task_pool::task_t i = 0; !stop.load(std::memory_order_relaxed); ++i) {
+            ipc::task_pool::task_t t;
+            o.push(i);
+            o.pop(t);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }};
+    auto start = std::chrono::steady_clock::now();
+    ipc::task_pool::task_t t {};
+    // might steal a task now and then, it's only the time spent that matters
+    for (int i = 0; (i < 1000) && w.take(t, 200); ++i) ;
+    auto spent = std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::steady_clock::now() - start).count();
+    stop.store(true, std::memory_order_relaxed);
+    other.join();
+    EXPECT_LT(spent, 5000);
+}
+
+#if !defined(IPC_OS_WINDOWS_)
+TEST(TaskPool, dead_worker) {
+    constexpr char const name[] = "test-task-pool-dead";
+    // all the deques but one are taken here
+    std::vector<std::unique_ptr<ipc::task_pool>> ws;
+    for (std::size_t i = 0; i + 1 < ipc::task_pool::max_workers; ++i) {
+        ws.emplace_back(new ipc::task_pool{name, 16});
+        ASSERT_TRUE(ws.back()->valid());
+    }
+    // the last one by a worker which dies with its tasks
+    pid_t pid = ::fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+        ipc::task_pool w {name, 16};
+        bool ok = w.valid() && w.push(1) && w.push(2) && w.push(3);
+        ::_exit(ok ? 0 : 1);
+    }
+    int status = 0;
+    ASSERT_EQ(::waitpid(pid, &status, 0), pid);
+    ASSERT_TRUE(WIFEXITED(status) && (WEXITSTATUS(status) == 0));
+
+    // its deque is taken over, with the tasks left in it
+    ipc::task_pool w {name, 16};
+    ASSERT_TRUE(w.valid());
+    ipc::task_pool::task_t t {};
+    for (ipc::task_pool::task_t i = 3; i > 0; --i) {
+        ASSERT_TRUE(w.pop(t));
+        EXPECT_EQ(t, i);
+    }
+    EXPECT_FALSE(w.pop(t));
+    // and there is no seat left
+    ipc::task_pool full {name, 16};
+    EXPECT_FALSE(full.valid());
+}
+#endif // !IPC_OS_WINDOWS_
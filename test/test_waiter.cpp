@@ -1,4 +1,5 @@
 #include <thread>
+#include <atomic>
 #include <iostream>
 
 #include "libipc/waiter.h"
@@ -65,4 +66,45 @@ TEST(Waiter, quit_waiting) {
     std::cout << "quit... \n";
 }
 
+TEST(Waiter, notify_one) {
+    // every token wakes up exactly one waiter, which takes it & leaves
+    constexpr int N = 4;
+    std::atomic<int> tokens {0}, taken {0}, waiting {0}, woken {0};
+    std::thread ts[N];
+    for (auto& t : ts) {
+        t = std::thread([&] {
+            ipc::detail::waiter waiter {"test-ipc-waiter-one"};
+            bool first = true;
+            // the predicate is checked once before sleeping, then once for each wakeup
+            EXPECT_TRUE(waiter.wait_if([&] {
+                if (first) {
+                    first = false;
+                    waiting.fetch_add(1);
+                }
+                else woken.fetch_add(1);
+                int n = tokens.load();
+                return (n == 0) || !tokens.compare_exchange_strong(n, n - 1);
+            }));
+            taken.fetch_add(1);
+        });
+    }
+    ipc::detail::waiter waiter {"test-ipc-waiter-one"};
+    while (waiting.load() < N) std::this_thread::yield();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    for (int i = 1; i <= N; ++i) {
+        woken.store(0);
+        tokens.fetch_add(1);
+        EXPECT_TRUE(waiter.notify());
+        while (taken.load() < i) std::this_thread::yield();
+        // give a second waiter, if woken up as well, the time to show up
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        EXPECT_EQ(woken.load(), 1) << i;
+    }
+    for (auto& t : ts) t.join();
+    EXPECT_EQ(tokens.load(), 0);
+    // nobody is waiting, notifying does nothing
+    EXPECT_TRUE(waiter.notify());
+    EXPECT_TRUE(waiter.broadcast());
+}
+
 } // internal-linkage
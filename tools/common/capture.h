@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+/**
+ * The capture file shared by ipc-record & ipc-replay.
+ *
+ * A file_head, then one record_head followed by its payload for each message,
+ * all in the byte order of the recording host.
+*/
+
+namespace capture {
+
+constexpr char magic[8] = {'I', 'P', 'C', 'R', 'E', 'C', '0', '1'};
+
+enum : std::uint32_t {
+    version = 1
+};
+
+enum : std::uint32_t { // file_head::kind
+    route   = 0, // ipc::route
+    channel = 1  // ipc::channel
+};
+
+struct file_head {
+    char          magic[8];
+    std::uint32_t version;
+    std::uint32_t kind;
+    char          name[64]; // the recorded channel
+};
+
+struct record_head {
+    std::uint64_t stamp; // ns since the recording started
+    std::uint32_t size;
+    std::uint32_t reserved;
+};
+
+inline bool check(file_head const &head) noexcept {
+    return (std::memcmp(head.magic, magic, sizeof(magic)) == 0) && (head.version == version);
+}
+
+} // namespace capture
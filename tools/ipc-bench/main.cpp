@@ -0,0 +1,365 @@
+
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <limits>
+
+#include "libipc/ipc.h"
+
+namespace {
+
+/**
+ * Multi-process benchmark launcher.
+ *
+ * Forks N producer & M consumer processes talking over one ipc::channel,
+ * pins them onto cores chosen by a placement, and reports throughput & latency.
+ *
+ * Placements:
+ *  - any    : no pinning (scheduler decides)
+ *  - smt    : all processes on the hardware threads of one core
+ *  - llc    : one process per core, all cores sharing one L3 cache
+ *  - socket : producers on one package, consumers on another
+*/
+
+constexpr char const name__[] = "ipc-bench";
+
+struct cpu_info {
+    int cpu;
+    int core;    // core_id, unique within a package
+    int package; // physical_package_id
+    int llc;     // first cpu of the L3 (or last-level) cache
+};
+
+struct options {
+    int producers = 1;
+    int consumers = 1;
+    int messages  = 100000;
+    std::size_t size = 64;
+    std::vector<std::string> placements {"any", "smt", "llc", "socket"};
+};
+
+struct msg_head {
+    std::uint64_t stamp; // ns, CLOCK_MONOTONIC is system-wide
+    std::int32_t  id;    // -1 means quit
+};
+
+struct report_t {
+    std::uint64_t count;
+    std::uint64_t bytes;
+    std::uint64_t elapsed; // ns
+    std::uint64_t p50, p99, max; // ns
+};
+
+inline std::uint64_t now_ns() noexcept {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+int read_int(std::string const &path, int def) {
+    std::ifstream in {path};
+    int val;
+    return (in >> val) ? val : def;
+}
+
+/// "0-3,8,10-11" => {0, 1, 2, 3, 8, 10, 11}
+std::vector<int> parse_cpu_list(std::string const &str) {
+    std::vector<int> ret;
+    std::stringstream ss {str};
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        auto dash = item.find('-');
+        int b = std::atoi(item.c_str());
+        int e = (dash == std::string::npos) ? b : std::atoi(item.c_str() + dash + 1);
+        for (int i = b; i <= e; ++i) ret.push_back(i);
+    }
+    return ret;
+}
+
+int llc_of(int cpu) {
+    std::string base = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/cache/";
+    // the highest cache index is the last-level cache
+    std::string shared;
+    for (int i = 0;; ++i) {
+        std::ifstream in {base + "index" + std::to_string(i) + "/shared_cpu_list"};
+        std::string line;
+        if (!std::getline(in, line)) break;
+        shared = line;
+    }
+    auto cpus = parse_cpu_list(shared);
+    return cpus.empty() ? 0 : cpus.front();
+}
+
+std::vector<cpu_info> topology() {
+    std::vector<cpu_info> ret;
+    cpu_set_t cs;
+    CPU_ZERO(&cs);
+    if (::sched_getaffinity(0, sizeof(cs), &cs) != 0) return ret;
+    for (int i = 0; i < CPU_SETSIZE; ++i) {
+        if (!CPU_ISSET(i, &cs)) continue;
+        std::string base = "/sys/devices/system/cpu/cpu" + std::to_string(i) + "/topology/";
+        ret.push_back({i, read_int(base + "core_id", i),
+                          read_int(base + "physical_package_id", 0), llc_of(i)});
+    }
+    return ret;
+}
+
+/**
+ * Returns the cpus of the producers followed by the consumers,
+ * or an empty list if the topology can not satisfy the placement.
+ * For "any", every entry is -1.
+*/
+std::vector<int> place(std::vector<cpu_info> const &topo, std::string const &how, int n, int m) {
+    int total = n + m;
+    if (how == "any") {
+        return std::vector<int>(static_cast<std::size_t>(total), -1);
+    }
+    std::vector<int> ret;
+    if (how == "smt") {
+        // the core with the most hardware threads
+        std::map<std::pair<int, int>, std::vector<int>> cores;
+        for (auto const &ci : topo) cores[{ci.package, ci.core}].push_back(ci.cpu);
+        std::vector<int> const *best = nullptr;
+        for (auto const &pr : cores) {
+            if (best == nullptr || pr.second.size() > best->size()) best = &pr.second;
+        }
+        if (best == nullptr || best->size() < 2) return {};
+        for (int i = 0; i < total; ++i) ret.push_back((*best)[static_cast<std::size_t>(i) % best->size()]);
+        return ret;
+    }
+    if (how == "llc") {
+        // one thread per core, inside the largest last-level cache
+        std::map<int, std::map<std::pair<int, int>, int>> llcs;
+        for (auto const &ci : topo) llcs[ci.llc].emplace(std::make_pair(ci.package, ci.core), ci.cpu);
+        std::map<std::pair<int, int>, int> const *best = nullptr;
+        for (auto const &pr : llcs) {
+            if (best == nullptr || pr.second.size() > best->size()) best = &pr.second;
+        }
+        if (best == nullptr || static_cast<int>(best->size()) < total) return {};
+        for (auto const &pr : *best) {
+            if (static_cast<int>(ret.size()) == total) break;
+            ret.push_back(pr.second);
+        }
+        return ret;
+    }
+    if (how == "socket") {
+        std::map<int, std::vector<int>> pkgs;
+        for (auto const &ci : topo) pkgs[ci.package].push_back(ci.cpu);
+        if (pkgs.size() < 2) return {};
+        auto const &pa = pkgs.begin()->second;
+        auto const &pb = std::next(pkgs.begin())->second;
+        for (int i = 0; i < n; ++i) ret.push_back(pa[static_cast<std::size_t>(i) % pa.size()]);
+        for (int i = 0; i < m; ++i) ret.push_back(pb[static_cast<std::size_t>(i) % pb.size()]);
+        return ret;
+    }
+    return {};
+}
+
+void pin_to(int cpu) {
+    if (cpu < 0) return;
+    cpu_set_t cs;
+    CPU_ZERO(&cs);
+    CPU_SET(cpu, &cs);
+    if (::sched_setaffinity(0, sizeof(cs), &cs) != 0) {
+        std::cerr << "pin_to: sched_setaffinity(" << cpu << ") failed.\n";
+    }
+}
+
+void do_produce(options const &opt, std::string const &name, int id) {
+    ipc::channel chan {name.c_str(), ipc::sender};
+    if (!chan.wait_for_recv(static_cast<std::size_t>(opt.consumers), 10000)) {
+        std::cerr << __func__ << ": wait receivers failed.\n";
+        return;
+    }
+    std::vector<ipc::byte_t> buff((std::max)(opt.size, sizeof(msg_head)));
+    auto head = reinterpret_cast<msg_head *>(buff.data());
+    head->id = id;
+    for (int i = 0; i < opt.messages; ++i) {
+        head->stamp = now_ns();
+        if (!chan.send(buff.data(), buff.size(), 1000)) {
+            std::cerr << __func__ << ": send failed.\n";
+            return;
+        }
+    }
+}
+
+report_t do_consume(options const &opt, std::string const &name) {
+    ipc::channel chan {name.c_str(), ipc::receiver};
+    std::vector<std::uint64_t> lats;
+    std::uint64_t expected = static_cast<std::uint64_t>(opt.producers) * static_cast<std::uint64_t>(opt.messages);
+    lats.reserve(static_cast<std::size_t>(expected));
+    report_t rp {};
+    std::uint64_t first = 0, last = 0;
+    int quits = 0;
+    while (quits < opt.producers) {
+        auto buf = chan.recv(3000);
+        if (buf.empty()) break; // timeout
+        auto now  = now_ns();
+        auto head = buf.get<msg_head const *>();
+        if (head->id < 0) {
+            // not timed: it is only sent after all the producers have been waited for
+            ++quits;
+            continue;
+        }
+        if (first == 0) first = now;
+        last = now;
+        lats.push_back(now - head->stamp);
+        rp.count += 1;
+        rp.bytes += buf.size();
+    }
+    rp.elapsed = last - first;
+    if (!lats.empty()) {
+        std::sort(lats.begin(), lats.end());
+        rp.p50 = lats[lats.size() / 2];
+        rp.p99 = lats[(lats.size() * 99) / 100];
+        rp.max = lats.back();
+    }
+    return rp;
+}
+
+template <typename F>
+pid_t spawn(int cpu, int fd, F &&job) {
+    std::cout.flush(); // don't let children replay buffered output
+    pid_t pid = ::fork();
+    if (pid != 0) return pid;
+    pin_to(cpu);
+    report_t rp = job();
+    if (fd >= 0 && ::write(fd, &rp, sizeof(rp)) != sizeof(rp)) {
+        std::cerr << "spawn: write report failed.\n";
+    }
+    std::cerr.flush();
+    // a forked child must not run the exit handlers & static destructors of its parent
+    ::_exit(0);
+}
+
+void run(options const &opt, std::vector<int> const &cpus, std::string const &how) {
+    std::string name = std::string{name__} + "-" + how + "-" + std::to_string(::getpid());
+    std::vector<pid_t> pids;
+    std::vector<int> fds;
+    for (int k = 0; k < opt.consumers; ++k) {
+        int pfd[2];
+        if (::pipe(pfd) != 0) return;
+        pids.push_back(spawn(cpus[static_cast<std::size_t>(opt.producers + k)], pfd[1], [&opt, &name] {
+            return do_consume(opt, name);
+        }));
+        ::close(pfd[1]);
+        fds.push_back(pfd[0]);
+    }
+    std::vector<pid_t> senders;
+    for (int k = 0; k < opt.producers; ++k) {
+        senders.push_back(spawn(cpus[static_cast<std::size_t>(k)], -1, [&opt, &name, k] {
+            do_produce(opt, name, k);
+            return report_t{};
+        }));
+    }
+    for (auto pid : senders) ::waitpid(pid, nullptr, 0);
+    {
+        // tell consumers that all producers have finished
+        ipc::channel chan {name.c_str(), ipc::sender};
+        msg_head quit {0, -1};
+        for (int k = 0; k < opt.producers; ++k) chan.send(&quit, sizeof(quit), 1000);
+    }
+
+    std::uint64_t count = 0, bytes = 0, elapsed = 0, p50 = 0, p99 = 0, max = 0;
+    for (std::size_t k = 0; k < fds.size(); ++k) {
+        report_t rp {};
+        if (::read(fds[k], &rp, sizeof(rp)) != sizeof(rp)) {
+            std::cerr << "run: read report failed.\n";
+        }
+        ::close(fds[k]);
+        ::waitpid(pids[k], nullptr, 0);
+        count  += rp.count;
+        bytes  += rp.bytes;
+        elapsed = (std::max)(elapsed, rp.elapsed);
+        p50     = (std::max)(p50, rp.p50);
+        p99     = (std::max)(p99, rp.p99);
+        max     = (std::max)(max, rp.max);
+    }
+    double sec = double(elapsed) / 1e9;
+    std::cout << how << "\t[" << opt.producers << "-" << opt.consumers << "]\t"
+              << "cpus:";
+    for (auto c : cpus) std::cout << " " << c;
+    std::cout << "\n\t" << count << " msgs, "
+              << (sec > 0 ? double(count) / sec : 0.0) << " msg/s, "
+              << (sec > 0 ? double(bytes) / sec / (1024 * 1024) : 0.0) << " MB/s, "
+              << "latency p50/p99/max: " << p50 / 1000.0 << "/" << p99 / 1000.0 << "/" << max / 1000.0 << " us"
+              << std::endl;
+}
+
+/// A whole decimal number in [1, max], or false.
+bool parse_num(std::string const &str, long long max, long long &val) {
+    if (str.empty()) return false;
+    char *end = nullptr;
+    errno = 0;
+    val = std::strtoll(str.c_str(), &end, 10);
+    return (errno == 0) && (*end == '\0') && (val > 0) && (val <= max);
+}
+
+bool parse(int argc, char **argv, options &opt) {
+    constexpr long long int_max = (std::numeric_limits<int>::max)();
+    for (int i = 1; i < argc; ++i) {
+        std::string arg {argv[i]};
+        if (i + 1 >= argc) return false;
+        std::string val {argv[++i]};
+        long long num = 0;
+        if      (arg == "-p") { if (!parse_num(val, 1024   , num)) return false; opt.producers = static_cast<int>(num); }
+        else if (arg == "-c") { if (!parse_num(val, 1024   , num)) return false; opt.consumers = static_cast<int>(num); }
+        else if (arg == "-n") { if (!parse_num(val, int_max, num)) return false; opt.messages  = static_cast<int>(num); }
+        else if (arg == "-s") { if (!parse_num(val, int_max, num)) return false; opt.size      = static_cast<std::size_t>(num); }
+        else if (arg == "-t") {
+            opt.placements.clear();
+            std::stringstream ss {val};
+            for (std::string item; std::getline(ss, item, ',');) opt.placements.push_back(item);
+        }
+        else return false;
+    }
+    return (opt.producers > 0) && (opt.consumers > 0) && (opt.messages > 0);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    options opt;
+    if (!parse(argc, argv, opt)) {
+        std::cout << "usage: " << argv[0]
+                  << " [-p producers] [-c consumers] [-n messages] [-s size]"
+                     " [-t any,smt,llc,socket]\n";
+        return -1;
+    }
+    ::signal(SIGPIPE, SIG_IGN);
+
+    auto topo = topology();
+    std::set<int> cores, llcs, pkgs;
+    for (auto const &ci : topo) {
+        cores.insert(ci.package * 65536 + ci.core);
+        llcs .insert(ci.llc);
+        pkgs .insert(ci.package);
+    }
+    std::cout << "topology: " << topo.size() << " cpus, " << cores.size() << " cores, "
+              << llcs.size() << " llc, " << pkgs.size() << " packages\n";
+
+    for (auto const &how : opt.placements) {
+        auto cpus = place(topo, how, opt.producers, opt.consumers);
+        if (cpus.empty()) {
+            std::cout << how << "\t[" << opt.producers << "-" << opt.consumers << "]\tskipped (not supported by this topology)\n";
+            continue;
+        }
+        run(opt, cpus, how);
+    }
+    return 0;
+}
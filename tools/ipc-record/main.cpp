@@ -0,0 +1,228 @@
+
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#include "libipc/ipc.h"
+
+#include "capture.h"
+
+namespace {
+
+/**
+ * Trace recorder.
+ *
+ * Joins a broadcast channel as one more receiver, and writes every message,
+ * with its time & size, into a capture file (see: capture.h).
+ * Receiving & writing run on two threads swapping two large buffers,
+ * so the file is written sequentially in big blocks while receiving goes on.
+*/
+
+constexpr char const name__[] = "ipc-record";
+
+struct options {
+    std::string   name;
+    std::uint32_t kind    = capture::route;
+    std::string   file;
+    std::uint64_t count   = 0; // 0: unlimited
+    std::uint64_t seconds = 0; // 0: unlimited
+    std::size_t   buffer  = 8 * 1024 * 1024;
+};
+
+std::atomic<bool> quit__ {false};
+
+inline std::uint64_t now_ns() noexcept {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/// Writes full buffers on its own thread, while the other one is being filled.
+class double_buffer {
+    int                     fd_;
+    std::vector<char>       bufs_[2];
+    std::size_t             fill_ = 0;     // the buffer being filled
+    bool                    busy_ = false; // the other one is being written
+    bool                    stop_ = false;
+    bool                    fail_ = false;
+    std::mutex              lock_;
+    std::condition_variable cond_;
+    std::thread             writer_;
+
+    bool write_all(char const *data, std::size_t size) {
+        while (size > 0) {
+            ssize_t n = ::write(fd_, data, size);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                std::cerr << name__ << ": write failed: " << std::strerror(errno) << "\n";
+                return false;
+            }
+            data += n;
+            size -= static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> guard {lock_};
+        for (;;) {
+            cond_.wait(guard, [this] { return busy_ || stop_; });
+            if (!busy_) return;
+            auto &buf = bufs_[fill_ ^ 1];
+            guard.unlock();
+            bool ok = write_all(buf.data(), buf.size());
+            buf.clear();
+            guard.lock();
+            fail_ = fail_ || !ok;
+            busy_ = false;
+            cond_.notify_all();
+        }
+    }
+
+    /// Hands the filled buffer to the writer, waiting for it to finish the previous one.
+    void swap() {
+        std::unique_lock<std::mutex> guard {lock_};
+        cond_.wait(guard, [this] { return !busy_; });
+        fill_ ^= 1;
+        busy_  = true;
+        cond_.notify_all();
+    }
+
+public:
+    double_buffer(int fd, std::size_t size)
+        : fd_{fd} {
+        bufs_[0].reserve(size);
+        bufs_[1].reserve(size);
+        writer_ = std::thread{[this] { run(); }};
+    }
+
+    ~double_buffer() {
+        flush();
+        {
+            std::lock_guard<std::mutex> guard {lock_};
+            stop_ = true;
+            cond_.notify_all();
+        }
+        writer_.join();
+    }
+
+    bool failed() {
+        std::lock_guard<std::mutex> guard {lock_};
+        return fail_;
+    }
+
+    void append(void const *data, std::size_t size) {
+        auto *buf = &bufs_[fill_];
+        if (!buf->empty() && (buf->size() + size > buf->capacity())) {
+            swap();
+            buf = &bufs_[fill_];
+        }
+        auto p = static_cast<char const *>(data);
+        buf->insert(buf->end(), p, p + size);
+    }
+
+    void flush() {
+        if (!bufs_[fill_].empty()) swap();
+        std::unique_lock<std::mutex> guard {lock_};
+        cond_.wait(guard, [this] { return !busy_; });
+    }
+};
+
+template <typename Chan>
+int record(options const &opt) {
+    int fd = ::open(opt.file.c_str(), O_CREAT | O_TRUNC | O_WRONLY | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::cerr << name__ << ": cannot open " << opt.file << ": " << std::strerror(errno) << "\n";
+        return -1;
+    }
+    Chan chan {opt.name.c_str(), ipc::receiver};
+    std::uint64_t count = 0, bytes = 0;
+    std::uint64_t start = now_ns();
+    {
+        double_buffer out {fd, opt.buffer};
+        capture::file_head head {};
+        std::memcpy(head.magic, capture::magic, sizeof(head.magic));
+        head.version = capture::version;
+        head.kind    = opt.kind;
+        std::strncpy(head.name, opt.name.c_str(), sizeof(head.name) - 1);
+        out.append(&head, sizeof(head));
+
+        std::uint64_t deadline = (opt.seconds == 0) ? 0 : start + opt.seconds * 1000000000ull;
+        while (!quit__.load(std::memory_order_relaxed)) {
+            if ((opt.count != 0) && (count >= opt.count)) break;
+            if ((deadline != 0) && (now_ns() >= deadline)) break;
+            // wake up now and then to check for quitting
+            auto buf = chan.recv(100);
+            if (buf.empty()) continue;
+            capture::record_head rec {};
+            rec.stamp = now_ns() - start;
+            rec.size  = static_cast<std::uint32_t>(buf.size());
+            out.append(&rec, sizeof(rec));
+            out.append(buf.data(), buf.size());
+            ++count;
+            bytes += buf.size();
+        }
+        out.flush();
+        if (out.failed()) {
+            ::close(fd);
+            return -1;
+        }
+    }
+    ::close(fd);
+    double sec = double(now_ns() - start) / 1e9;
+    std::cout << name__ << ": " << count << " msgs, " << bytes << " bytes in " << sec << " s, "
+              << (sec > 0 ? double(bytes) / sec / (1024 * 1024) : 0.0) << " MB/s -> " << opt.file << std::endl;
+    return 0;
+}
+
+bool parse(int argc, char **argv, options &opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg {argv[i]};
+        if (i + 1 >= argc) return false;
+        std::string val {argv[++i]};
+        if      (arg == "-r") opt.name    = val;
+        else if (arg == "-o") opt.file    = val;
+        else if (arg == "-n") opt.count   = std::stoull(val);
+        else if (arg == "-d") opt.seconds = std::stoull(val);
+        else if (arg == "-b") opt.buffer  = static_cast<std::size_t>(std::stoul(val)) * 1024 * 1024;
+        else if (arg == "-k") {
+            if      (val == "route"  ) opt.kind = capture::route;
+            else if (val == "channel") opt.kind = capture::channel;
+            else return false;
+        }
+        else return false;
+    }
+    if (opt.file.empty()) opt.file = opt.name + ".ipcrec";
+    return !opt.name.empty() && (opt.name.size() < sizeof(capture::file_head::name)) && (opt.buffer > 0);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    options opt;
+    if (!parse(argc, argv, opt)) {
+        std::cout << "usage: " << argv[0]
+                  << " -r name [-k route|channel] [-o file] [-n messages] [-d seconds] [-b buffer-MB]\n";
+        return -1;
+    }
+    auto on_exit = [](int) { quit__.store(true, std::memory_order_relaxed); };
+    ::signal(SIGINT , on_exit);
+    ::signal(SIGTERM, on_exit);
+    ::signal(SIGHUP , on_exit);
+
+    if (opt.kind == capture::channel) {
+        return record<ipc::channel>(opt);
+    }
+    return record<ipc::route>(opt);
+}
@@ -0,0 +1,216 @@
+
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <limits>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+
+#include "libipc/ipc.h"
+
+#include "capture.h"
+
+namespace {
+
+/**
+ * Trace-driven load generator.
+ *
+ * Replays a capture file of ipc-record into a channel, with the recorded sizes
+ * and inter-arrival times (or scaled by a speed factor), while forked consumer processes
+ * measure the latency of every message large enough to carry a timestamp.
+*/
+
+constexpr char const name__[] = "ipc-replay";
+
+struct options {
+    std::string file;
+    std::string name;          // default: the recorded channel
+    double      speed     = 1; // 0: as fast as possible
+    int         consumers = 1; // 0: external receivers only, no latency report
+};
+
+struct msg_head {
+    std::uint64_t stamp; // ns, CLOCK_MONOTONIC is system-wide
+    std::uint64_t quit;
+};
+
+constexpr std::uint64_t quit_mark = (std::numeric_limits<std::uint64_t>::max)();
+
+struct report_t {
+    std::uint64_t count;
+    std::uint64_t bytes;
+    std::uint64_t p50, p99, p999, max; // ns
+};
+
+inline std::uint64_t now_ns() noexcept {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/**
+ * Receives until the quit mark. The trace may pause for any time,
+ * so a timeout only checks whether the producer (our parent) has gone.
+*/
+template <typename Chan>
+report_t do_consume(std::string const &name, pid_t producer) {
+    Chan chan {name.c_str(), ipc::receiver};
+    std::vector<std::uint64_t> lats;
+    report_t rp {};
+    for (;;) {
+        ipc::buff_t buf = chan.recv(1000);
+        if (buf.empty()) {
+            if (::getppid() != producer) break;
+            continue;
+        }
+        auto now = now_ns();
+        if (buf.size() >= sizeof(msg_head)) {
+            auto head = buf.get<msg_head const *>();
+            if (head->quit == quit_mark) break;
+            lats.push_back(now - head->stamp);
+        }
+        rp.count += 1;
+        rp.bytes += buf.size();
+    }
+    if (!lats.empty()) {
+        std::sort(lats.begin(), lats.end());
+        rp.p50  = lats[lats.size() / 2];
+        rp.p99  = lats[(lats.size() * 99) / 100];
+        rp.p999 = lats[(lats.size() * 999) / 1000];
+        rp.max  = lats.back();
+    }
+    return rp;
+}
+
+template <typename F>
+pid_t spawn(int fd, F &&job) {
+    std::cout.flush(); // don't let children replay buffered output
+    pid_t pid = ::fork();
+    if (pid != 0) return pid;
+    report_t rp = job();
+    if (::write(fd, &rp, sizeof(rp)) != sizeof(rp)) {
+        std::cerr << "spawn: write report failed.\n";
+    }
+    std::exit(0);
+}
+
+template <typename Chan>
+int replay(options const &opt, std::ifstream &in) {
+    std::vector<pid_t> pids;
+    std::vector<int>   fds;
+    pid_t self = ::getpid();
+    for (int k = 0; k < opt.consumers; ++k) {
+        int pfd[2];
+        if (::pipe(pfd) != 0) return -1;
+        pids.push_back(spawn(pfd[1], [&opt, self] { return do_consume<Chan>(opt.name, self); }));
+        ::close(pfd[1]);
+        fds.push_back(pfd[0]);
+    }
+
+    Chan chan {opt.name.c_str(), ipc::sender};
+    if (!chan.wait_for_recv((std::max)(opt.consumers, 1), 10000)) {
+        std::cerr << name__ << ": wait receivers failed.\n";
+        return -1;
+    }
+    std::vector<char> buf;
+    std::uint64_t count = 0, bytes = 0, lag = 0;
+    std::uint64_t start = now_ns();
+    for (capture::record_head rec {}; in.read(reinterpret_cast<char *>(&rec), sizeof(rec));) {
+        buf.resize(rec.size);
+        if (!in.read(buf.data(), static_cast<std::streamsize>(rec.size))) {
+            std::cerr << name__ << ": truncated record #" << count << "\n";
+            break;
+        }
+        if (opt.speed > 0) {
+            // keep the recorded timing, scaled
+            auto due = start + static_cast<std::uint64_t>(double(rec.stamp) / opt.speed);
+            auto now = now_ns();
+            if (now < due) {
+                std::this_thread::sleep_for(std::chrono::nanoseconds(due - now));
+            }
+            else lag = (std::max)(lag, now - due);
+        }
+        if (rec.size >= sizeof(msg_head)) {
+            msg_head head {now_ns(), 0};
+            std::memcpy(buf.data(), &head, sizeof(head));
+        }
+        if (rec.size == 0) continue;
+        if (!chan.send(buf.data(), buf.size(), ipc::default_timeout)) {
+            std::cerr << name__ << ": send failed at record #" << count << "\n";
+        }
+        ++count;
+        bytes += rec.size;
+    }
+    double sec = double(now_ns() - start) / 1e9;
+    {
+        // the end of the trace: consumers wait for it however long the trace pauses
+        msg_head quit {0, quit_mark};
+        for (int k = 0; k < opt.consumers; ++k) chan.send(&quit, sizeof(quit), 1000);
+    }
+    std::cout << name__ << ": " << count << " msgs, " << bytes << " bytes in " << sec << " s, "
+              << (sec > 0 ? double(count) / sec : 0.0) << " msg/s, "
+              << (sec > 0 ? double(bytes) / sec / (1024 * 1024) : 0.0) << " MB/s, "
+              << "max lag behind the schedule: " << lag / 1000.0 << " us\n";
+
+    for (std::size_t k = 0; k < fds.size(); ++k) {
+        report_t rp {};
+        if (::read(fds[k], &rp, sizeof(rp)) != sizeof(rp)) {
+            std::cerr << name__ << ": read report failed.\n";
+        }
+        ::close(fds[k]);
+        ::waitpid(pids[k], nullptr, 0);
+        std::cout << "consumer " << k << ": " << rp.count << " msgs, " << rp.bytes << " bytes, "
+                  << "latency p50/p99/p99.9/max: " << rp.p50 / 1000.0 << "/" << rp.p99 / 1000.0 << "/"
+                  << rp.p999 / 1000.0 << "/" << rp.max / 1000.0 << " us\n";
+    }
+    return 0;
+}
+
+bool parse(int argc, char **argv, options &opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg {argv[i]};
+        if (i + 1 >= argc) return false;
+        std::string val {argv[++i]};
+        if      (arg == "-i") opt.file      = val;
+        else if (arg == "-r") opt.name      = val;
+        else if (arg == "-x") opt.speed     = std::stod(val);
+        else if (arg == "-c") opt.consumers = std::stoi(val);
+        else return false;
+    }
+    return !opt.file.empty() && (opt.speed >= 0) && (opt.consumers >= 0);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    options opt;
+    if (!parse(argc, argv, opt)) {
+        std::cout << "usage: " << argv[0]
+                  << " -i file [-r name] [-x speed (0: unpaced)] [-c consumers (0: external only)]\n";
+        return -1;
+    }
+    ::signal(SIGPIPE, SIG_IGN);
+
+    std::ifstream in {opt.file, std::ios::binary};
+    capture::file_head head {};
+    if (!in.read(reinterpret_cast<char *>(&head), sizeof(head)) || !capture::check(head)) {
+        std::cerr << name__ << ": " << opt.file << " is not a capture file.\n";
+        return -1;
+    }
+    head.name[sizeof(head.name) - 1] = '\0';
+    if (opt.name.empty()) opt.name = head.name;
+
+    if (head.kind == capture::channel) {
+        return replay<ipc::channel>(opt, in);
+    }
+    return replay<ipc::route>(opt, in);
+}